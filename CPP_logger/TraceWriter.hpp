@@ -14,6 +14,10 @@
 #include <sstream>
 #include <memory>
 #include <functional>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 namespace std
 {
@@ -352,6 +356,31 @@ namespace llvm
             }
         };
 
+        // Connects to a viewer started with "sail_viewer --listen <socketPath>" and
+        // returns a stream to pass to TraceWriter, so that the trace is sent to the
+        // viewer instead of being written to a file. The writes block while the
+        // viewer is behind. Returns nullptr if no viewer is listening on the socket
+        inline std::unique_ptr<raw_fd_ostream> connectToViewer(const std::string &socketPath)
+        {
+            struct sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (socketPath.size() >= sizeof(address.sun_path))
+                return nullptr;
+            std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0)
+                return nullptr;
+            if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+            {
+                close(fd);
+                return nullptr;
+            }
+            // The stream owns the socket and closes it, which ends the trace in the viewer
+            return std::make_unique<raw_fd_ostream>(fd, true);
+        }
+
     }
 }
 
@@ -0,0 +1,34 @@
+/*
+ * Bump allocator for the text and tables owned by a trace
+ */
+#include "arena.h"
+
+using namespace std;
+
+namespace sail {
+
+    void *Arena::allocateSlow(size_t bytes) {
+        // Allocations larger than a quarter of a block get a block of their own,
+        // and the free space of the current block is kept for the next ones
+        if (bytes > blockSize / 4) {
+            unique_ptr<char[]> block(new char[bytes]);
+            char *data = block.get();
+            blocks.insert(next == nullptr ? blocks.end() : blocks.end() - 1, move(block));
+            allocatedBytes += bytes;
+            return data;
+        }
+        blocks.emplace_back(new char[blockSize]);
+        allocatedBytes += blockSize;
+        char *data = blocks.back().get();
+        next = data + bytes;
+        end = data + blockSize;
+        return data;
+    }
+
+    void Arena::clear() {
+        blocks.clear();
+        next = end = nullptr;
+        allocatedBytes = 0;
+    }
+
+}
@@ -0,0 +1,130 @@
+/*
+ * Bump allocator for the text and tables owned by a trace
+ *
+ * Memory is taken from large blocks and is only released all at once, when
+ * the arena is cleared or destroyed. Loading a trace then does a few large
+ * allocations instead of one per line or per list, and freeing it does not
+ * walk the lists. Only types without a destructor can be stored.
+ */
+#ifndef SAIL_ARENA_H
+#define SAIL_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    class Arena {
+        private:
+            vector<unique_ptr<char[]>> blocks;
+            size_t blockSize;
+            // Free space of the current block
+            char *next = nullptr;
+            char *end = nullptr;
+            size_t allocatedBytes = 0;
+
+            void *allocateSlow(size_t bytes);
+
+        public:
+            explicit Arena(size_t blockSize = 256 << 10) : blockSize(blockSize) {}
+            Arena(Arena &&) = default;
+            Arena &operator=(Arena &&) = default;
+
+            // The alignment is at most the one of max_align_t
+            void *allocate(size_t bytes, size_t alignment) {
+                uintptr_t start = (reinterpret_cast<uintptr_t>(next) + alignment - 1) & ~uintptr_t(alignment - 1);
+                if (next == nullptr || start + bytes > reinterpret_cast<uintptr_t>(end))
+                    return allocateSlow(bytes);
+                next = reinterpret_cast<char *>(start + bytes);
+                return reinterpret_cast<char *>(start);
+            }
+            // Grows the last allocation in place if there is room after it
+            bool extend(void *data, size_t bytes, size_t newBytes) {
+                char *dataEnd = static_cast<char *>(data) + bytes;
+                if (dataEnd != next || newBytes - bytes > size_t(end - next))
+                    return false;
+                next += newBytes - bytes;
+                return true;
+            }
+            template <typename T> T *allocateArray(size_t count) {
+                static_assert(is_trivially_destructible<T>::value, "Arena objects are not destroyed");
+                static_assert(alignof(T) <= alignof(max_align_t), "Arena blocks are aligned for max_align_t");
+                return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+            }
+            string_view copy(string_view text) {
+                if (text.empty())
+                    return string_view();
+                char *data = allocateArray<char>(text.size());
+                memcpy(data, text.data(), text.size());
+                return string_view(data, text.size());
+            }
+
+            // Releases all the blocks
+            void clear();
+
+            size_t blockCount() const       { return blocks.size(); }
+            size_t memoryUsage() const      { return allocatedBytes; }
+    };
+
+    // Growable array stored in an arena. The arena is passed to the calls that
+    // grow it, so that a table of arrays does not store it for every array.
+    // Growing moves the items unless they were the last allocation of the
+    // arena, and leaves the old items in the arena
+    template <typename T> class ArenaVector {
+        private:
+            T *items = nullptr;
+            size_t count = 0;
+            size_t capacity = 0;
+
+            void reserve(Arena &arena, size_t newCount) {
+                if (newCount <= capacity)
+                    return;
+                size_t newCapacity = max(newCount, max<size_t>(capacity * 2, 4));
+                if (items != nullptr && arena.extend(items, capacity * sizeof(T), newCapacity * sizeof(T))) {
+                    capacity = newCapacity;
+                    return;
+                }
+                T *newItems = arena.allocateArray<T>(newCapacity);
+                if (count > 0)
+                    memcpy(newItems, items, count * sizeof(T));
+                items = newItems;
+                capacity = newCapacity;
+            }
+
+        public:
+            static_assert(is_trivially_copyable<T>::value, "ArenaVector items are copied with memcpy");
+
+            void push_back(Arena &arena, const T &item) {
+                reserve(arena, count + 1);
+                items[count++] = item;
+            }
+            void append(Arena &arena, const T *begin, const T *end) {
+                reserve(arena, count + (end - begin));
+                if (begin != end)
+                    memcpy(items + count, begin, (end - begin) * sizeof(T));
+                count += end - begin;
+            }
+            // Forgets the items, which stay in the arena until it is cleared
+            void reset()                            { items = nullptr; count = capacity = 0; }
+
+            size_t size() const                     { return count; }
+            bool empty() const                      { return count == 0; }
+            const T *begin() const                  { return items; }
+            const T *end() const                    { return items + count; }
+            const T &operator[](size_t i) const     { return items[i]; }
+            const T &front() const                  { return items[0]; }
+            const T &back() const                   { return items[count - 1]; }
+            size_t memoryUsage() const              { return capacity * sizeof(T); }
+    };
+
+}
+
+#endif
@@ -0,0 +1,322 @@
+/*
+ * Benchmarks of the trace loading and query paths, run with --benchmark
+ */
+#include "benchmark.h"
+#include "compression.h"
+#include "mappedfile.h"
+#include "parallel.h"
+#include "parser.h"
+#include "scanner.h"
+#include "trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    // Repeats body until at least a second has passed and returns
+    // the average time of one repetition in seconds
+    template <typename Body>
+    static double timeRepeated(Body body) {
+        auto startTime = chrono::steady_clock::now();
+        chrono::duration<double> elapsed(0);
+        unsigned long long repetitions = 0;
+        while (elapsed.count() < 1.0) {
+            body();
+            repetitions++;
+            elapsed = chrono::steady_clock::now() - startTime;
+        }
+        return elapsed.count() / repetitions;
+    }
+
+    static void printThroughput(const string &name, double bytes, double seconds) {
+        cout << "  " << name << " : " << bytes / seconds / (1024 * 1024) << " MB/s\n";
+    }
+
+    // Throughput of the scanner alone, over the whole trace :
+    // finding the instruction boundaries, and tokenizing every header
+    static void benchmarkScanner(const MappedFile &traceFile) {
+        cout << "Scanner\n";
+        SCANNER_KIND defaultScanner = getScanner();
+        const char *data = traceFile.begin();
+        size_t size = traceFile.size();
+        for (SCANNER_KIND kind : { SCANNER_SCALAR, SCANNER_SSE2, SCANNER_AVX2 }) {
+            if (!setScanner(kind))
+                continue;
+            size_t instructions = 0, tokens = 0;
+            double boundaryTime = timeRepeated([&]() {
+                instructions = 0;
+                for (size_t offset = 0; offset < size; offset++) {
+                    offset = findInstructionBoundary(data, size, offset);
+                    instructions++;
+                }
+            });
+            double tokenizeTime = timeRepeated([&]() {
+                tokens = 0;
+                for (size_t offset = 0; offset < size; ) {
+                    Instruction instruction = parseInstruction(nextInstruction(traceFile.view(), offset));
+                    tokens += instruction.argumentCount + 1;
+                }
+            });
+            printThroughput(string(getScannerName(kind)) + " instruction boundaries", size, boundaryTime);
+            printThroughput(string(getScannerName(kind)) + " boundaries + header tokens", size, tokenizeTime);
+        }
+        setScanner(defaultScanner);
+    }
+
+    template <typename Body>
+    static double timeOnce(Body body) {
+        auto startTime = chrono::steady_clock::now();
+        body();
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - startTime;
+        return elapsed.count();
+    }
+
+    // Load time of the text trace against the same trace in the binary format
+    static void benchmarkBinaryLoad(const string &filename) {
+        string binaryFilename = (filesystem::temp_directory_path() / "sail_benchmark.sailb").string();
+        double textTime, binaryTime;
+        {
+            unique_ptr<Trace> trace;
+            textTime = timeOnce([&]() { trace.reset(new Trace(filename, 0, false)); trace->load(); });
+            if (!trace->writeBinary(binaryFilename)) {
+                cout << "Unable to write " << binaryFilename << "\n";
+                return;
+            }
+        }
+        binaryTime = timeOnce([&]() { Trace trace(binaryFilename, 0, false); trace.load(); });
+        remove(binaryFilename.c_str());
+
+        cout << "Binary trace\n";
+        cout << "  text trace load : " << textTime << " s\n";
+        cout << "  binary trace load : " << binaryTime << " s\n";
+    }
+
+    // Load time of the text trace against the same trace compressed
+    // with each of the supported formats
+    static void benchmarkCompressedLoad(const string &filename, const MappedFile &traceFile) {
+        cout << "Compressed trace\n";
+        double textTime = timeOnce([&]() { Trace trace(filename, 0, false); trace.load(); });
+        cout << "  text trace load : " << textTime << " s\n";
+        for (COMPRESSION_TYPE type : { COMPRESSION_GZIP, COMPRESSION_ZSTD }) {
+            if (!isCompressionSupported(type))
+                continue;
+            string compressedFilename = (filesystem::temp_directory_path() /
+                    (string("sail_benchmark.") + getCompressionName(type))).string();
+            if (!writeCompressed(compressedFilename, traceFile.view(), type)) {
+                cout << "Unable to write " << compressedFilename << "\n";
+                continue;
+            }
+            size_t compressedSize = filesystem::file_size(compressedFilename);
+            double compressedTime = timeOnce([&]() { Trace trace(compressedFilename, 0, false); trace.load(); });
+            remove(compressedFilename.c_str());
+            cout << "  " << getCompressionName(type) << " trace load : " << compressedTime << " s (" <<
+                compressedSize / (1024.0 * 1024.0) << " MB compressed)\n";
+        }
+    }
+
+    // Resolution of node names to NodeIDs, as done for every instruction :
+    // 100M lookups of names drawn from 1M distinct nodes in 1000 groups
+    static void benchmarkNodeNames() {
+        const size_t nodeCount = 1000000, lookupCount = 100000000;
+        vector<string> names;
+        names.reserve(nodeCount);
+        for (size_t i = 0; i < nodeCount; i++)
+            names.push_back("function" + to_string(i % 1000) + ":node" + to_string(i));
+
+        Graph graph;
+        double internTime = timeOnce([&]() {
+            for (const string &name : names)
+                graph.getNodeID(name);
+        });
+        NodeID checksum = 0;
+        double lookupTime = timeOnce([&]() {
+            // Linear congruential sequence, so that the lookups do not follow the table order
+            uint64_t state = 1;
+            for (size_t i = 0; i < lookupCount; i++) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                checksum += graph.getNodeID(names[(state >> 33) % nodeCount]);
+            }
+        });
+
+        cout << "Node names (checksum " << checksum << ")\n";
+        cout << "  " << nodeCount / 1000000 << "M new names : " << internTime << " s\n";
+        cout << "  " << lookupCount / 1000000 << "M lookups : " << lookupTime << " s (" <<
+            lookupCount / lookupTime / 1e6 << " M lookups/s)\n";
+    }
+
+    // Memory used by the events of the timeline, and the time taken to scan
+    // all of them, on 10M events
+    static void benchmarkTimeline() {
+        const size_t eventCount = 10000000;
+        const string_view tags[] = { "Meet from Predecessors", "After b = &y", "Transfer", "" };
+        const string_view info = "p -> {a, x}\n";
+        Timeline timeline;
+        for (size_t i = 0; i < eventCount; i++)
+            timeline.addEvent(EVENT_TYPE(i % 3), tags[i % 4], info, i % 1000, (i * 7) % 1000);
+
+        unsigned long long checksum = 0;
+        double scanTime = timeRepeated([&]() {
+            for (unsigned long long i = 0; i < timeline.size(); i++)
+                checksum += timeline.getEventType(i) + timeline.getEventNode1(i) + timeline.getEventTagID(i);
+        });
+        cout << "Timeline (checksum " << checksum << ")\n";
+        cout << "  event columns : " << double(timeline.eventMemoryUsage()) / eventCount << " bytes per event\n";
+        cout << "  scan of " << eventCount / 1000000 << "M events : " << scanTime << " s\n";
+
+        // Moves to the previous and next event of the location of random events
+        const size_t lookupCount = 10000000;
+        timeline.compactLocationEvents();
+        mt19937_64 random(1);
+        double lookupTime = timeRepeated([&]() {
+            for (size_t i = 0; i < lookupCount; i++) {
+                unsigned long long index = random() % eventCount;
+                EVENT_TYPE type = timeline.getEventType(index);
+                NodeID node1 = timeline.getEventNode1(index), node2 = timeline.getEventNode2(index);
+                checksum += timeline.findPrevEvent(index, type, node1, node2).value_or(index) +
+                    timeline.findNextEvent(index, type, node1, node2).value_or(index);
+            }
+        });
+        cout << "  location index : " << double(timeline.locationMemoryUsage()) / eventCount <<
+            " bytes per event, " << timeline.locationCount() << " locations\n";
+        cout << "  " << lookupCount / 1000000 << "M prev / next lookups : " << lookupTime << " s (checksum " <<
+            checksum << ")\n";
+
+        // Hovering : the last event before a random position at the location of a random event,
+        // or at a node without events for one query in four. The queries only read the timeline,
+        // so they also run on all the threads at once
+        const Timeline &queries = timeline;
+        atomic<unsigned long long> hoverChecksum{0};
+        auto hover = [&](size_t hoverCount, uint64_t seed) {
+            mt19937_64 random(seed);
+            unsigned long long sum = 0;
+            for (size_t i = 0; i < hoverCount; i++) {
+                unsigned long long event = random() % eventCount, index = random() % eventCount;
+                NodeID node1 = random() % 4 == 0 ? 1000 + event % 1000 : queries.getEventNode1(event);
+                sum += queries.findPrevEvent(index, queries.getEventType(event), node1,
+                        queries.getEventNode2(event)).value_or(index);
+            }
+            hoverChecksum += sum;
+        };
+        const size_t hoverCount = 10000000;
+        unsigned jobs = defaultJobs();
+        double hoverTime = timeRepeated([&]() { hover(hoverCount, 1); });
+        double parallelHoverTime = timeRepeated([&]() {
+            parallelFor(jobs, jobs, [&](size_t job) { hover(hoverCount / jobs, job + 1); });
+        });
+        cout << "  hover queries : " << hoverCount / hoverTime / 1e6 << " M/s on 1 thread, " <<
+            hoverCount / parallelHoverTime / 1e6 << " M/s on " << jobs << " threads (checksum " <<
+            hoverChecksum << ")\n";
+    }
+
+    // Memory used by the info bodies of the trace, and the time to read the
+    // lines of a body at random (cache misses) or while scrubbing (cache hits)
+    static void benchmarkInfoStore(const MappedFile &traceFile) {
+        InfoStore infos;
+        size_t bodyBytes = 0;
+        string_view contents = traceFile.view();
+        double addTime = timeOnce([&]() {
+            for (size_t offset = 0; offset < contents.size(); ) {
+                Instruction instruction = parseInstruction(nextInstruction(contents, offset));
+                if (instruction.type == INSTR_NODEINFO || instruction.type == INSTR_EDGEINFO ||
+                        instruction.type == INSTR_GLOBALINFO) {
+                    infos.add(instruction.body);
+                    bodyBytes += instruction.body.size();
+                }
+            }
+        });
+        if (infos.size() == 0)
+            return;
+
+        // Every random access decompresses a block
+        const size_t randomCount = 10000, scrubCount = 1000000;
+        uint64_t checksum = 0;
+        auto readBody = [&](uint64_t body) {
+            size_t lineCount;
+            const LineID *lines = infos.getLines(body, lineCount);
+            for (size_t i = 0; i < lineCount; i++)
+                checksum += lines[i];
+        };
+        mt19937_64 random(1);
+        double randomTime = timeOnce([&]() {
+            for (size_t i = 0; i < randomCount; i++)
+                readBody(random() % infos.size());
+        });
+        // Moves back and forth around a position, along with a body further away for the hovered node
+        double scrubTime = timeOnce([&]() {
+            uint64_t position = random() % infos.size();
+            for (size_t i = 0; i < scrubCount; i++) {
+                position = (position + (i % 64 < 48 ? 1 : infos.size() - 1)) % infos.size();
+                readBody(position);
+                readBody(position / 2);
+            }
+        });
+        // Same random accesses with three quarters of the blocks evicted to the spill file
+        infos.setBudget(infos.blockMemoryUsage() / 4);
+        double spilledTime = timeOnce([&]() {
+            for (size_t i = 0; i < randomCount; i++)
+                readBody(random() % infos.size());
+        });
+
+        cout << "Info store (checksum " << checksum << ")\n";
+        cout << "  " << infos.addedCount() << " bodies, " << infos.size() << " stored, " <<
+            infos.lineCount() << " distinct lines : " << addTime << " s\n";
+        cout << "  body text : " << bodyBytes / (1024.0 * 1024.0) << " MB, store : " <<
+            infos.memoryUsage() / (1024.0 * 1024.0) << " MB (blocks " <<
+            infos.uncompressedBlockSize() / (1024.0 * 1024.0) << " MB before " <<
+            getCompressionName(getBlockCompression()) << " compression)\n";
+        cout << "  random access : " << randomTime / randomCount * 1e9 << " ns per body\n";
+        cout << "  scrubbing : " << scrubTime / (scrubCount * 2) * 1e9 << " ns per body\n";
+        cout << "  random access with " << infos.spilledSize() / (1024.0 * 1024.0) << " MB spilled : " <<
+            spilledTime / randomCount * 1e9 << " ns per body\n";
+    }
+
+    // Load time of a generated trace whose 100k info bodies are drawn from a pool
+    // of 30k bodies, so that most of them are found in blocks sealed long before
+    static void benchmarkRepeatedBodies() {
+        string filename = (filesystem::temp_directory_path() / "sail_benchmark_repeated.trace").string();
+        {
+            ofstream out(filename, ios::binary);
+            mt19937_64 random(1);
+            vector<string> pool(30000);
+            for (string &body : pool)
+                for (int line = 0; line < 8; line++)
+                    body += "p" + to_string(random() % 2000) + " -> {a" + to_string(random() % 7) + ", x}\n";
+            for (size_t i = 0; i < 100000; i++)
+                out << ">>nodeinfo g:n" << i % 50 << " t" << i % 5 << "\n" << pool[random() % pool.size()];
+        }
+        size_t traceSize = filesystem::file_size(filename);
+        double serialTime = timeOnce([&]() { Trace trace(filename, 1, false); trace.load(); });
+        double parallelTime = timeOnce([&]() { Trace trace(filename, 0, false); trace.load(); });
+        remove(filename.c_str());
+
+        cout << "Repeated info bodies (" << traceSize / (1024.0 * 1024.0) << " MB trace)\n";
+        printThroughput("serial load", traceSize, serialTime);
+        printThroughput("parallel load", traceSize, parallelTime);
+    }
+
+    void runBenchmarks(const string &filename) {
+        MappedFile traceFile;
+        if (!traceFile.open(filename)) {
+            cout << "Unable to open tracefile " << filename << "\n";
+            return;
+        }
+        cout << "Benchmarking on " << filename << " (" << traceFile.size() << " bytes)\n";
+        benchmarkScanner(traceFile);
+        benchmarkBinaryLoad(filename);
+        benchmarkCompressedLoad(filename, traceFile);
+        benchmarkNodeNames();
+        benchmarkTimeline();
+        benchmarkInfoStore(traceFile);
+        benchmarkRepeatedBodies();
+    }
+
+}
@@ -0,0 +1,18 @@
+/*
+ * Benchmarks of the trace loading and query paths, run with --benchmark
+ */
+#ifndef SAIL_BENCHMARK_H
+#define SAIL_BENCHMARK_H
+
+#include <string>
+
+using namespace std;
+
+namespace sail {
+
+    // Runs the benchmarks on the given trace and prints the results
+    void runBenchmarks(const string &filename);
+
+}
+
+#endif
@@ -0,0 +1,342 @@
+/*
+ * Binary trace format (.sailb)
+ */
+#include "binarytrace.h"
+#include "trace.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace sail {
+
+    bool isBinaryTrace(string_view data) {
+        return data.size() >= sizeof(BINARY_TRACE_MAGIC) &&
+            memcmp(data.data(), BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) == 0;
+    }
+
+    // Returns true if str is a view into text
+    static bool isViewInto(string_view str, string_view text) {
+        uintptr_t start = reinterpret_cast<uintptr_t>(str.data());
+        uintptr_t textStart = reinterpret_cast<uintptr_t>(text.data());
+        return !str.empty() && start >= textStart && start - textStart <= text.size() &&
+            str.size() <= text.size() - (start - textStart);
+    }
+
+    uint32_t BinaryTraceWriter::addString(string_view str) {
+        auto entry = stringIDs.find(str);
+        if (entry != stringIDs.end())
+            return entry->second;
+        uint32_t stringID = stringIDs.size();
+        if (isViewInto(str, text)) {
+            append(SECTION_STRINGS, BinaryString{ uint64_t(str.data() - text.data()) | BINARY_STRING_EXTERNAL, str.size() });
+        } else {
+            vector<char> &stringData = sections[SECTION_STRING_DATA];
+            append(SECTION_STRINGS, BinaryString{ stringData.size(), str.size() });
+            stringData.insert(stringData.end(), str.begin(), str.end());
+        }
+        stringIDs.emplace(str, stringID);
+        return stringID;
+    }
+
+    void BinaryTraceWriter::setSource(const string &path, uint64_t size, int64_t modificationTime, uint64_t contentHash) {
+        sections[SECTION_SOURCE].clear();
+        append(SECTION_SOURCE, BinarySource{ size, modificationTime, contentHash, addString(path), 0 });
+    }
+
+    bool BinaryTraceWriter::write(const string &filename) {
+        BinaryTraceHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC));
+        header.version = BINARY_TRACE_VERSION;
+        header.byteOrder = BINARY_TRACE_BYTE_ORDER;
+
+        // Sections follow the header, each one aligned on 8 bytes
+        uint64_t offset = sizeof(header);
+        for (int section = 0; section < SECTION_COUNT; section++) {
+            offset = (offset + 7) & ~7ULL;
+            header.sections[section][0] = offset;
+            header.sections[section][1] = sections[section].size();
+            offset += sections[section].size();
+        }
+
+        ofstream outputstream(filename, ios::binary | ios::trunc);
+        if (!outputstream)
+            return false;
+        outputstream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        uint64_t written = sizeof(header);
+        const char padding[8] = {};
+        for (int section = 0; section < SECTION_COUNT; section++) {
+            outputstream.write(padding, header.sections[section][0] - written);
+            outputstream.write(sections[section].data(), sections[section].size());
+            written = header.sections[section][0] + sections[section].size();
+        }
+        return bool(outputstream);
+    }
+
+    // Size of a single record in every section
+    static const size_t SECTION_RECORD_SIZE[SECTION_COUNT] = {
+        sizeof(BinaryString), 1, sizeof(BinaryNode),
+        sizeof(uint64_t), sizeof(uint32_t), sizeof(uint64_t), sizeof(BinaryEvent),
+        sizeof(BinaryLocation), sizeof(uint32_t), sizeof(BinarySource), sizeof(uint32_t),
+        sizeof(uint32_t), sizeof(uint64_t)
+    };
+
+    bool BinaryTraceReader::open(string_view _data, string &error, string_view _text) {
+        data = _data;
+        text = _text;
+        if (!isBinaryTrace(data) || data.size() < sizeof(BinaryTraceHeader)) {
+            error = "Not a binary trace";
+            return false;
+        }
+        header = reinterpret_cast<const BinaryTraceHeader *>(data.data());
+        if (header->byteOrder != BINARY_TRACE_BYTE_ORDER) {
+            error = "Binary trace was written on a machine with a different byte order";
+            return false;
+        }
+        if (header->version != BINARY_TRACE_VERSION) {
+            error = "Unsupported binary trace version " + to_string(header->version) +
+                " (expected " + to_string(BINARY_TRACE_VERSION) + ")";
+            return false;
+        }
+        for (int section = 0; section < SECTION_COUNT; section++) {
+            uint64_t offset = header->sections[section][0], size = header->sections[section][1];
+            if (offset % 8 != 0 || offset > data.size() || size > data.size() - offset ||
+                    size % SECTION_RECORD_SIZE[section] != 0) {
+                error = "Binary trace section " + to_string(section) + " is corrupted";
+                return false;
+            }
+        }
+        if (header->sections[SECTION_INFO_TEXTS][1] > 0 && text.empty()) {
+            error = "Binary trace is the index of a text trace, open the text trace instead";
+            return false;
+        }
+        const BinaryString *strings = section<BinaryString>(SECTION_STRINGS);
+        uint64_t stringDataSize = header->sections[SECTION_STRING_DATA][1];
+        for (size_t i = 0; i < count<BinaryString>(SECTION_STRINGS); i++) {
+            uint64_t offset = strings[i].offset, size = stringDataSize;
+            if (offset & BINARY_STRING_EXTERNAL) {
+                if (text.empty()) {
+                    error = "Binary trace is the index of a text trace, open the text trace instead";
+                    return false;
+                }
+                offset &= ~BINARY_STRING_EXTERNAL;
+                size = text.size();
+            }
+            if (offset > size || strings[i].length > size - offset) {
+                error = "Binary trace string table is corrupted";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    string_view BinaryTraceReader::getString(uint32_t id) const {
+        if (id >= count<BinaryString>(SECTION_STRINGS))
+            return string_view();
+        const BinaryString &str = section<BinaryString>(SECTION_STRINGS)[id];
+        if (str.offset & BINARY_STRING_EXTERNAL)
+            return text.substr(str.offset & ~BINARY_STRING_EXTERNAL, str.length);
+        return string_view(section<char>(SECTION_STRING_DATA) + str.offset, str.length);
+    }
+
+    const BinarySource *BinaryTraceReader::getSource() const {
+        if (count<BinarySource>(SECTION_SOURCE) == 0)
+            return nullptr;
+        return section<BinarySource>(SECTION_SOURCE);
+    }
+
+    static void binaryTraceError(const string &message) {
+        cout << "Invalid binary trace : " << message << "\n";
+        exit(0);
+    }
+
+    void Graph::writeBinary(BinaryTraceWriter &writer) {
+        if (nodeNames.size() >= BINARY_NONE)
+            binaryTraceError("too many nodes");
+
+        // Rows are written in NodeID order rather than in the order of the groups
+        compact();
+        uint64_t edgeCount = 0;
+        for (NodeID nodeID = 0; nodeID < nodeNames.size(); nodeID++) {
+            auto contents = nodeContents.find(nodeID);
+            writer.append(SECTION_NODES, BinaryNode{
+                    writer.addString(nodeNames.getName(nodeID)),
+                    contents == nodeContents.end() ? BINARY_NONE : writer.addString(contents->second) });
+
+            writer.append(SECTION_EDGE_OFFSETS, edgeCount);
+            uint64_t position = nodePositions[nodeID];
+            for (uint64_t edge = edgeOffsets[position]; edge < edgeOffsets[position + 1]; edge++)
+                writer.append(SECTION_EDGE_TARGETS, uint32_t(edgeTargets[edge]));
+            edgeCount += edgeOffsets[position + 1] - edgeOffsets[position];
+        }
+        writer.append(SECTION_EDGE_OFFSETS, edgeCount);
+    }
+
+    void Graph::loadBinary(const BinaryTraceReader &reader) {
+        const BinaryNode *nodes = reader.section<BinaryNode>(SECTION_NODES);
+        size_t nodeCount = reader.count<BinaryNode>(SECTION_NODES);
+        for (size_t i = 0; i < nodeCount; i++) {
+            // Nodes are stored in NodeID order, so they get back the same IDs,
+            // and their groups are derived from their names as when parsing
+            if (getNodeID(reader.getString(nodes[i].name)) != i)
+                binaryTraceError("duplicate node " + string(reader.getString(nodes[i].name)));
+            if (nodes[i].contents != BINARY_NONE)
+                addNode(NodeID(i), reader.getString(nodes[i].contents));
+        }
+
+        const uint64_t *edgeOffsets = reader.section<uint64_t>(SECTION_EDGE_OFFSETS);
+        const uint32_t *edgeTargets = reader.section<uint32_t>(SECTION_EDGE_TARGETS);
+        size_t edgeCount = reader.count<uint32_t>(SECTION_EDGE_TARGETS);
+        if (reader.count<uint64_t>(SECTION_EDGE_OFFSETS) != nodeCount + 1)
+            binaryTraceError("edge offsets do not match the nodes");
+        for (size_t src = 0; src < nodeCount; src++) {
+            if (edgeOffsets[src] > edgeOffsets[src + 1] || edgeOffsets[src + 1] > edgeCount)
+                binaryTraceError("edge offsets are corrupted");
+            for (uint64_t edge = edgeOffsets[src]; edge < edgeOffsets[src + 1]; edge++) {
+                if (edgeTargets[edge] >= nodeCount)
+                    binaryTraceError("edge to an unknown node");
+                addEdge(NodeID(src), NodeID(edgeTargets[edge]));
+            }
+        }
+    }
+
+    void Timeline::writeBinary(BinaryTraceWriter &writer, const vector<string_view> &infoTexts) {
+        if (size() >= BINARY_NONE || infos.size() >= BINARY_NONE)
+            binaryTraceError("too many events");
+        if (!infoTexts.empty()) {
+            for (string_view text : infoTexts)
+                writer.appendTextRange(SECTION_INFO_TEXTS, text);
+        } else {
+            uint64_t infoLineCount = 0;
+            writer.append(SECTION_INFOS, infoLineCount);
+            for (unsigned long long i = 0; i < infos.size(); i++) {
+                size_t lineCount;
+                const LineID *lines = infos.getLines(i, lineCount);
+                for (size_t j = 0; j < lineCount; j++)
+                    writer.append(SECTION_INFO_LINES, lines[j]);
+                infoLineCount += lineCount;
+                writer.append(SECTION_INFOS, infoLineCount);
+            }
+            // After the bodies, whose lines are interned as they are read if they come from an index
+            for (LineID line = 0; line < infos.lineCount(); line++)
+                writer.append(SECTION_LINES, writer.addString(infos.getLine(line)));
+        }
+        // String of every tag, added on first use
+        vector<uint32_t> tagStrings(tags.size(), BINARY_NONE);
+        for (unsigned long long i = 0; i < size(); i++) {
+            uint32_t &tagString = tagStrings[eventTags[i]];
+            if (tagString == BINARY_NONE)
+                tagString = writer.addString(tags.getName(eventTags[i]));
+            writer.append(SECTION_EVENTS, BinaryEvent{ eventTypes[i], tagString,
+                    eventInfos[i] == NO_INFO_ID ? BINARY_NONE : eventInfos[i],
+                    eventNodes1[i], eventNodes2[i] });
+        }
+
+        uint64_t locationEventCount = 0;
+        for (LocationID id = 0; id < locationEvents.size(); id++) {
+            const EventLocation &location = locationEvents.getLocation(id);
+            uint64_t eventCount = locationEvents.getEventCount(id);
+            writer.append(SECTION_LOCATIONS, BinaryLocation{ location.type, location.node1, location.node2,
+                    uint32_t(eventCount), locationEventCount });
+            locationEvents.forEachEvent(id, [&writer](uint32_t eventIndex) {
+                writer.append(SECTION_LOCATION_EVENTS, eventIndex);
+            });
+            locationEventCount += eventCount;
+        }
+    }
+
+    void Timeline::loadBinary(const BinaryTraceReader &reader, unsigned long long nodeCount) {
+        const uint32_t *lines = reader.section<uint32_t>(SECTION_LINES);
+        size_t lineCount = reader.count<uint32_t>(SECTION_LINES);
+        const uint64_t *infoOffsets = reader.section<uint64_t>(SECTION_INFOS);
+        size_t infoCount = max<size_t>(reader.count<uint64_t>(SECTION_INFOS), 1) - 1;
+        const uint32_t *infoLines = reader.section<uint32_t>(SECTION_INFO_LINES);
+        size_t infoLineCount = reader.count<uint32_t>(SECTION_INFO_LINES);
+        const uint64_t *infoRanges = reader.section<uint64_t>(SECTION_INFO_TEXTS);
+        size_t infoRangeCount = reader.count<uint64_t>(SECTION_INFO_TEXTS);
+        const BinaryEvent *events = reader.section<BinaryEvent>(SECTION_EVENTS);
+        size_t eventCount = reader.count<BinaryEvent>(SECTION_EVENTS);
+
+        resize(eventCount);
+        if (infoRangeCount > 0) {
+            // The info strings of an index stay in the text trace, which is only
+            // read when they are displayed
+            if (infoRangeCount % 2 != 0 || infoCount != 0)
+                binaryTraceError("info texts are corrupted");
+            infoCount = infoRangeCount / 2;
+            string_view text = reader.getText();
+            for (size_t i = 0; i < infoCount; i++)
+                if (infoRanges[2 * i] > text.size() || infoRanges[2 * i + 1] > text.size() - infoRanges[2 * i])
+                    binaryTraceError("info " + to_string(i) + " is corrupted");
+            infos.attachText(text, infoRanges, infoCount);
+        } else {
+            // The lines are appended without hashing them, and the info strings are used in place
+            for (size_t i = 0; i < lineCount; i++)
+                infos.appendLine(reader.getString(lines[i]));
+            for (size_t i = 0; i < infoCount; i++) {
+                if (infoOffsets[i] > infoOffsets[i + 1] || infoOffsets[i + 1] > infoLineCount)
+                    binaryTraceError("info " + to_string(i) + " is corrupted");
+                for (uint64_t j = infoOffsets[i]; j < infoOffsets[i + 1]; j++)
+                    if (infoLines[j] >= lineCount)
+                        binaryTraceError("info " + to_string(i) + " is corrupted");
+            }
+            infos.attach(infoOffsets, infoLines, infoCount);
+        }
+        // TagID of every string used as a tag, interned on first use
+        size_t stringCount = reader.count<BinaryString>(SECTION_STRINGS);
+        vector<uint32_t> stringTags(stringCount, BINARY_NONE);
+        for (size_t i = 0; i < eventCount; i++) {
+            const BinaryEvent &event = events[i];
+            if (event.type > GLOBAL_INFO || (event.info != BINARY_NONE && event.info >= infoCount) ||
+                    event.tag >= stringCount ||
+                    event.node1 >= max(nodeCount, 1ULL) || event.node2 >= max(nodeCount, 1ULL))
+                binaryTraceError("event " + to_string(i) + " is corrupted");
+            uint32_t &tagID = stringTags[event.tag];
+            if (tagID == BINARY_NONE)
+                tagID = internTag(reader.getString(event.tag));
+            setEvent(i, EVENT_TYPE(event.type), tagID,
+                    event.info == BINARY_NONE ? NO_INFO : event.info, event.node1, event.node2);
+            tagEvents[tagID].push_back(tagEventArena, i);
+        }
+
+        const BinaryLocation *locations = reader.section<BinaryLocation>(SECTION_LOCATIONS);
+        const uint32_t *indices = reader.section<uint32_t>(SECTION_LOCATION_EVENTS);
+        size_t locationEventCount = reader.count<uint32_t>(SECTION_LOCATION_EVENTS);
+        for (size_t i = 0; i < reader.count<BinaryLocation>(SECTION_LOCATIONS); i++) {
+            const BinaryLocation &location = locations[i];
+            if (location.firstEvent > locationEventCount ||
+                    location.eventCount > locationEventCount - location.firstEvent)
+                binaryTraceError("event locations are corrupted");
+            const uint32_t *begin = indices + location.firstEvent, *end = begin + location.eventCount;
+            for (const uint32_t *index = begin; index != end; index++)
+                if (*index >= eventCount || (index != begin && *index <= *(index - 1)))
+                    binaryTraceError("event locations are corrupted");
+            locationEvents.append(EventLocation{ location.type, location.node1, location.node2 }, begin, end);
+        }
+        locationEvents.compact();
+    }
+
+    bool Trace::writeBinary(const string &binaryFilename) {
+        BinaryTraceWriter writer;
+        graph.writeBinary(writer);
+        timeline.writeBinary(writer);
+        return writer.write(binaryFilename);
+    }
+
+    void Trace::loadBinary(string_view contents) {
+        BinaryTraceReader reader;
+        string error;
+        if (!reader.open(contents, error))
+            binaryTraceError(error);
+        loadBinary(reader);
+    }
+
+    void Trace::loadBinary(const BinaryTraceReader &reader) {
+        graph.loadBinary(reader);
+        timeline.loadBinary(reader, graph.size());
+        timeline.indexEventGroups(graph);
+    }
+
+}
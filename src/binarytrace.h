@@ -0,0 +1,180 @@
+/*
+ * Binary trace format (.sailb)
+ *
+ * A .sailb file holds a fully parsed trace, so that it can be loaded
+ * without tokenizing the text format again. The file is memory mapped
+ * and the strings are used in place.
+ *
+ * Layout : a fixed size header followed by the sections listed in the
+ * header. Every section is an array of fixed size records, aligned on
+ * 8 bytes. Values are stored in the byte order of the machine that wrote
+ * the file, which is checked on load.
+ *
+ *  STRINGS         BinaryString per string (offset, length in STRING_DATA,
+ *                  or in the text trace for external strings)
+ *  STRING_DATA     Text of all the strings, each string stored once
+ *  NODES           BinaryNode per NodeID
+ *  EDGE_OFFSETS    uint64 per node + 1 : CSR offsets into EDGE_TARGETS
+ *  EDGE_TARGETS    uint32 destination NodeID per edge, sorted by source
+ *  INFOS           uint64 per info string + 1 : offsets into INFO_LINES
+ *  EVENTS          BinaryEvent per event in timeline order
+ *  LOCATIONS       BinaryLocation per node / edge / global location
+ *  LOCATION_EVENTS uint32 event indices, grouped by location and sorted
+ *  SOURCE          BinarySource identifying the text trace, for cache files
+ *  LINES           uint32 string per distinct info line
+ *  INFO_LINES      uint32 line per line of every info string
+ *  INFO_TEXTS      uint64 offset and length in the text trace per info string,
+ *                  instead of INFOS, LINES and INFO_LINES (sidecar index)
+ *
+ * Version history :
+ *  1 : Initial format
+ *  2 : SOURCE section
+ *  3 : External strings, stored in the text trace (sidecar index)
+ *  4 : Info strings stored as lines (LINES, INFO_LINES)
+ *  5 : Info strings of an index stored in the text trace (INFO_TEXTS)
+ *  6 : No GROUPS section nor group of the nodes, groups are derived from the node names
+ */
+#ifndef SAIL_BINARYTRACE_H
+#define SAIL_BINARYTRACE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    const char BINARY_TRACE_MAGIC[8] = { 'S', 'A', 'I', 'L', 'B', 'I', 'N', '\n' };
+    const uint32_t BINARY_TRACE_VERSION = 6;
+    const uint32_t BINARY_TRACE_BYTE_ORDER = 0x01020304;
+    // Marks a missing string or info (node without contents, event without info)
+    const uint32_t BINARY_NONE = 0xffffffff;
+    // Set in BinaryString::offset for strings that are stored in the
+    // text trace rather than in STRING_DATA
+    const uint64_t BINARY_STRING_EXTERNAL = 1ULL << 63;
+
+    enum BINARY_SECTION {
+        SECTION_STRINGS, SECTION_STRING_DATA, SECTION_NODES,
+        SECTION_EDGE_OFFSETS, SECTION_EDGE_TARGETS, SECTION_INFOS, SECTION_EVENTS,
+        SECTION_LOCATIONS, SECTION_LOCATION_EVENTS, SECTION_SOURCE, SECTION_LINES,
+        SECTION_INFO_LINES, SECTION_INFO_TEXTS, SECTION_COUNT
+    };
+
+    struct BinaryTraceHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        // Offset and size in bytes of every section
+        uint64_t sections[SECTION_COUNT][2];
+    };
+
+    struct BinaryString {
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    struct BinaryNode {
+        uint32_t name;
+        uint32_t contents;
+    };
+
+    struct BinaryEvent {
+        uint32_t type;
+        uint32_t tag;
+        uint32_t info;
+        uint32_t node1;
+        uint32_t node2;
+    };
+
+    struct BinaryLocation {
+        uint32_t type;
+        uint32_t node1;
+        uint32_t node2;
+        uint32_t eventCount;
+        uint64_t firstEvent;
+    };
+
+    // Text trace that a cached binary trace was created from
+    struct BinarySource {
+        uint64_t size;
+        int64_t modificationTime;
+        uint64_t contentHash;
+        uint32_t path;
+        uint32_t reserved;
+    };
+
+    // Returns true if the data starts with the .sailb magic
+    bool isBinaryTrace(string_view data);
+
+    // Collects the sections and writes them out as a .sailb file
+    class BinaryTraceWriter {
+        private:
+            vector<char> sections[SECTION_COUNT];
+            // Strings that were already added, to store each of them once
+            unordered_map<string_view, uint32_t> stringIDs;
+            // Text trace that external strings are stored in, if any
+            string_view text;
+
+        public:
+            // Strings added afterwards that are views into the text are stored
+            // as their offset in the text instead of being copied
+            void setText(string_view _text)    { text = _text; }
+
+            // Returns the ID of the string in the STRINGS section.
+            // The string has to stay alive until the file is written
+            uint32_t addString(string_view str);
+
+            template <typename T>
+            void append(BINARY_SECTION section, const T &record) {
+                const char *bytes = reinterpret_cast<const char *>(&record);
+                sections[section].insert(sections[section].end(), bytes, bytes + sizeof(T));
+            }
+            // Appends the offset and length of a view into the text trace
+            void appendTextRange(BINARY_SECTION section, string_view str) {
+                append(section, uint64_t(str.empty() ? 0 : str.data() - text.data()));
+                append(section, uint64_t(str.size()));
+            }
+
+            // Records the text trace this binary trace is a cache of
+            void setSource(const string &path, uint64_t size, int64_t modificationTime, uint64_t contentHash);
+
+            // Returns false if the file could not be written
+            bool write(const string &filename);
+    };
+
+    // Validated view of a mapped .sailb file
+    class BinaryTraceReader {
+        private:
+            string_view data;
+            string_view text;
+            const BinaryTraceHeader *header = nullptr;
+
+        public:
+            // Returns false along with a message if the file is not a valid .sailb file.
+            // text is the text trace that the external strings are stored in
+            bool open(string_view data, string &error, string_view text = string_view());
+
+            template <typename T>
+            const T *section(BINARY_SECTION section) const {
+                return reinterpret_cast<const T *>(data.data() + header->sections[section][0]);
+            }
+            template <typename T>
+            size_t count(BINARY_SECTION section) const {
+                return header->sections[section][1] / sizeof(T);
+            }
+
+            // Returns the string with the given ID, or an empty string for BINARY_NONE
+            string_view getString(uint32_t id) const;
+            // Text trace that the external strings are stored in
+            string_view getText() const     { return text; }
+
+            // Returns the text trace this binary trace is a cache of, if any
+            const BinarySource *getSource() const;
+    };
+
+}
+
+#endif
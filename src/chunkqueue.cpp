@@ -0,0 +1,53 @@
+/*
+ * Bounded queue of trace text passed from a reader thread to the parser
+ */
+#include "chunkqueue.h"
+
+using namespace std;
+
+namespace sail {
+
+    bool ChunkQueue::push(vector<char> chunk) {
+        unique_lock<mutex> lock(queueMutex);
+        // A chunk larger than the queue is accepted once the queue is empty
+        notFull.wait(lock, [&]() { return closed || queuedBytes == 0 || queuedBytes + chunk.size() <= maxBytes; });
+        if (closed)
+            return false;
+        queuedBytes += chunk.size();
+        chunks.push_back(move(chunk));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool ChunkQueue::pop(vector<char> &text) {
+        unique_lock<mutex> lock(queueMutex);
+        notEmpty.wait(lock, [&]() { return closed || !chunks.empty(); });
+        if (chunks.empty())
+            return false;
+        if (chunks.size() == 1) {
+            text = move(chunks.front());
+        } else {
+            text.clear();
+            text.reserve(queuedBytes);
+            for (vector<char> &chunk : chunks)
+                text.insert(text.end(), chunk.begin(), chunk.end());
+        }
+        chunks.clear();
+        queuedBytes = 0;
+        notFull.notify_all();
+        return true;
+    }
+
+    void ChunkQueue::close() {
+        lock_guard<mutex> lock(queueMutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    size_t ChunkQueue::size() {
+        lock_guard<mutex> lock(queueMutex);
+        return queuedBytes;
+    }
+
+}
@@ -0,0 +1,56 @@
+/*
+ * Bounded queue of trace text passed from a reader thread to the parser
+ */
+#ifndef SAIL_CHUNKQUEUE_H
+#define SAIL_CHUNKQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    // Text queued between the reader and the parser by default
+    const size_t CHUNK_QUEUE_SIZE = 64 << 20;
+
+    // The reader pushes chunks of text as it receives them and the parser
+    // takes everything that is queued at once. push() blocks while the queue
+    // is full, so that a fast producer waits for the parser instead of
+    // making the viewer fall behind or use unbounded memory
+    class ChunkQueue {
+        private:
+            mutex queueMutex;
+            condition_variable notEmpty;
+            condition_variable notFull;
+            deque<vector<char>> chunks;
+            size_t queuedBytes = 0;
+            size_t maxBytes;
+            bool closed = false;
+
+        public:
+            explicit ChunkQueue(size_t _maxBytes = CHUNK_QUEUE_SIZE) : maxBytes(_maxBytes) {}
+            ChunkQueue(const ChunkQueue &) = delete;
+            ChunkQueue &operator=(const ChunkQueue &) = delete;
+
+            // Waits for room in the queue and appends the chunk.
+            // Returns false if the queue was closed
+            bool push(vector<char> chunk);
+
+            // Waits for text and moves all the queued chunks into text, in order.
+            // Returns false once the queue is closed and empty
+            bool pop(vector<char> &text);
+
+            // Ends the stream : push() fails and pop() returns the remaining text
+            void close();
+
+            // Bytes waiting to be parsed
+            size_t size();
+    };
+
+}
+
+#endif
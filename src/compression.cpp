@@ -0,0 +1,258 @@
+/*
+ * Compressed traces : detection and streaming decompression of gzip and zstd,
+ * and compression of in memory blocks
+ */
+#include "compression.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+#ifdef SAIL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SAIL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+namespace sail {
+
+    // Size of the decompressed chunks handed to the parser
+    const size_t DECOMPRESS_CHUNK_SIZE = 4 << 20;
+    // Size of the compressed input given to the library at once
+    const size_t DECOMPRESS_INPUT_SIZE = 1 << 20;
+
+    COMPRESSION_TYPE detectCompression(string_view data) {
+        if (data.size() >= 2 && uint8_t(data[0]) == 0x1f && uint8_t(data[1]) == 0x8b)
+            return COMPRESSION_GZIP;
+        if (data.size() >= 4 && uint8_t(data[0]) == 0x28 && uint8_t(data[1]) == 0xb5 &&
+                uint8_t(data[2]) == 0x2f && uint8_t(data[3]) == 0xfd)
+            return COMPRESSION_ZSTD;
+        return COMPRESSION_NONE;
+    }
+
+    bool isCompressionSupported(COMPRESSION_TYPE type) {
+        switch (type) {
+            case COMPRESSION_NONE:
+                return true;
+#ifdef SAIL_HAVE_ZLIB
+            case COMPRESSION_GZIP:
+                return true;
+#endif
+#ifdef SAIL_HAVE_ZSTD
+            case COMPRESSION_ZSTD:
+                return true;
+#endif
+            default:
+                return false;
+        }
+    }
+
+    const char *getCompressionName(COMPRESSION_TYPE type) {
+        switch (type) {
+            case COMPRESSION_GZIP:  return "gzip";
+            case COMPRESSION_ZSTD:  return "zstd";
+            default:                return "none";
+        }
+    }
+
+#ifdef SAIL_HAVE_ZLIB
+    static bool decompressGzip(string_view data, ChunkQueue &queue, atomic<size_t> &consumedBytes, string &error) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        // 32 : detect the gzip or zlib header
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            error = "Unable to initialize zlib";
+            queue.close();
+            return false;
+        }
+        size_t offset = 0;
+        vector<char> chunk(DECOMPRESS_CHUNK_SIZE);
+        stream.next_out = reinterpret_cast<Bytef *>(chunk.data());
+        stream.avail_out = chunk.size();
+        int status = Z_OK;
+        while (status != Z_STREAM_END || stream.avail_in > 0 || offset < data.size()) {
+            // Files can hold several gzip members one after the other
+            if (status == Z_STREAM_END)
+                inflateReset(&stream);
+            if (stream.avail_in == 0) {
+                if (offset == data.size())
+                    break;
+                size_t inputSize = min(data.size() - offset, DECOMPRESS_INPUT_SIZE);
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data() + offset));
+                stream.avail_in = inputSize;
+                offset += inputSize;
+            }
+            status = inflate(&stream, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+                break;
+            consumedBytes = offset - stream.avail_in;
+
+            if (stream.avail_out == 0) {
+                if (!queue.push(move(chunk))) {
+                    inflateEnd(&stream);
+                    return true;
+                }
+                chunk = vector<char>(DECOMPRESS_CHUNK_SIZE);
+                stream.next_out = reinterpret_cast<Bytef *>(chunk.data());
+                stream.avail_out = chunk.size();
+            }
+        }
+        if (status != Z_STREAM_END)
+            error = stream.msg != nullptr ? stream.msg : "truncated gzip data";
+        inflateEnd(&stream);
+
+        chunk.resize(chunk.size() - stream.avail_out);
+        if (!chunk.empty())
+            queue.push(move(chunk));
+        queue.close();
+        return status == Z_STREAM_END;
+    }
+#endif
+
+#ifdef SAIL_HAVE_ZSTD
+    static bool decompressZstd(string_view data, ChunkQueue &queue, atomic<size_t> &consumedBytes, string &error) {
+        ZSTD_DCtx *context = ZSTD_createDCtx();
+        ZSTD_inBuffer input = { data.data(), 0, 0 };
+        vector<char> chunk(DECOMPRESS_CHUNK_SIZE);
+        ZSTD_outBuffer output = { chunk.data(), chunk.size(), 0 };
+        while (true) {
+            if (input.pos == input.size && input.size < data.size())
+                input.size = min(data.size(), input.size + DECOMPRESS_INPUT_SIZE);
+            // 0 once a frame is decoded and flushed completely
+            size_t remaining = ZSTD_decompressStream(context, &output, &input);
+            if (ZSTD_isError(remaining)) {
+                error = ZSTD_getErrorName(remaining);
+                break;
+            }
+            consumedBytes = input.pos;
+
+            if (output.pos == output.size) {
+                if (!queue.push(move(chunk))) {
+                    ZSTD_freeDCtx(context);
+                    return true;
+                }
+                chunk = vector<char>(DECOMPRESS_CHUNK_SIZE);
+                output = { chunk.data(), chunk.size(), 0 };
+            } else if (input.pos == data.size()) {
+                // Everything was decoded and flushed
+                if (remaining != 0)
+                    error = "truncated zstd data";
+                break;
+            }
+        }
+        ZSTD_freeDCtx(context);
+
+        chunk.resize(output.pos);
+        if (!chunk.empty())
+            queue.push(move(chunk));
+        queue.close();
+        return error.empty();
+    }
+#endif
+
+    bool decompress(string_view data, COMPRESSION_TYPE type, ChunkQueue &queue,
+            atomic<size_t> &consumedBytes, string &error) {
+        switch (type) {
+#ifdef SAIL_HAVE_ZLIB
+            case COMPRESSION_GZIP:
+                return decompressGzip(data, queue, consumedBytes, error);
+#endif
+#ifdef SAIL_HAVE_ZSTD
+            case COMPRESSION_ZSTD:
+                return decompressZstd(data, queue, consumedBytes, error);
+#endif
+            default:
+                error = string(getCompressionName(type)) + " compression is not supported by this build";
+                queue.close();
+                return false;
+        }
+    }
+
+    bool writeCompressed(const string &filename, string_view data, COMPRESSION_TYPE type) {
+        vector<char> compressed;
+        switch (type) {
+#ifdef SAIL_HAVE_ZLIB
+            case COMPRESSION_GZIP: {
+                z_stream stream;
+                memset(&stream, 0, sizeof(stream));
+                // 16 : write a gzip header
+                if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                    return false;
+                compressed.resize(deflateBound(&stream, data.size()));
+                stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+                stream.avail_in = data.size();
+                stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+                stream.avail_out = compressed.size();
+                int status = deflate(&stream, Z_FINISH);
+                compressed.resize(stream.total_out);
+                deflateEnd(&stream);
+                if (status != Z_STREAM_END)
+                    return false;
+                break;
+            }
+#endif
+#ifdef SAIL_HAVE_ZSTD
+            case COMPRESSION_ZSTD: {
+                compressed.resize(ZSTD_compressBound(data.size()));
+                size_t size = ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), 3);
+                if (ZSTD_isError(size))
+                    return false;
+                compressed.resize(size);
+                break;
+            }
+#endif
+            default:
+                return false;
+        }
+        ofstream outputstream(filename, ios::binary | ios::trunc);
+        outputstream.write(compressed.data(), compressed.size());
+        return bool(outputstream);
+    }
+
+    COMPRESSION_TYPE getBlockCompression() {
+#if defined(SAIL_HAVE_ZSTD)
+        return COMPRESSION_ZSTD;
+#elif defined(SAIL_HAVE_ZLIB)
+        return COMPRESSION_GZIP;
+#else
+        return COMPRESSION_NONE;
+#endif
+    }
+
+    void compressBlock(string_view data, vector<char> &compressed) {
+        // Neither library fails with an output buffer of the bound size
+#if defined(SAIL_HAVE_ZSTD)
+        compressed.resize(ZSTD_compressBound(data.size()));
+        compressed.resize(ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), 1));
+#elif defined(SAIL_HAVE_ZLIB)
+        // zlib format rather than gzip : blocks do not need a header
+        uLongf size = compressBound(data.size());
+        compressed.resize(size);
+        compress2(reinterpret_cast<Bytef *>(compressed.data()), &size,
+                reinterpret_cast<const Bytef *>(data.data()), data.size(), Z_BEST_SPEED);
+        compressed.resize(size);
+#else
+        compressed.assign(data.begin(), data.end());
+#endif
+        compressed.shrink_to_fit();
+    }
+
+    bool decompressBlock(string_view compressed, char *data, size_t size) {
+#if defined(SAIL_HAVE_ZSTD)
+        size_t decompressedSize = ZSTD_decompress(data, size, compressed.data(), compressed.size());
+        return !ZSTD_isError(decompressedSize) && decompressedSize == size;
+#elif defined(SAIL_HAVE_ZLIB)
+        uLongf decompressedSize = size;
+        return uncompress(reinterpret_cast<Bytef *>(data), &decompressedSize,
+                reinterpret_cast<const Bytef *>(compressed.data()), compressed.size()) == Z_OK &&
+            decompressedSize == size;
+#else
+        if (compressed.size() != size)
+            return false;
+        memcpy(data, compressed.data(), size);
+        return true;
+#endif
+    }
+
+}
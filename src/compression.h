@@ -0,0 +1,49 @@
+/*
+ * Compressed traces : detection and streaming decompression of gzip and zstd,
+ * and compression of in memory blocks
+ *
+ * Support for each format is compiled in when its library is found by the
+ * Makefile (SAIL_HAVE_ZLIB, SAIL_HAVE_ZSTD).
+ */
+#ifndef SAIL_COMPRESSION_H
+#define SAIL_COMPRESSION_H
+
+#include "chunkqueue.h"
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    enum COMPRESSION_TYPE { COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD };
+
+    // Detects the compression of the data from its magic bytes
+    COMPRESSION_TYPE detectCompression(string_view data);
+    bool isCompressionSupported(COMPRESSION_TYPE type);
+    const char *getCompressionName(COMPRESSION_TYPE type);
+
+    // Decompresses the data and pushes the text into the queue in chunks,
+    // then closes the queue. consumedBytes is updated with the amount of
+    // compressed data decompressed so far. Stops early if the queue is closed.
+    // Returns false along with a message if the data is corrupted
+    bool decompress(string_view data, COMPRESSION_TYPE type, ChunkQueue &queue,
+            atomic<size_t> &consumedBytes, string &error);
+
+    // Writes the data compressed in the given format (used by the benchmarks).
+    // Returns false if the file could not be written
+    bool writeCompressed(const string &filename, string_view data, COMPRESSION_TYPE type);
+
+    // Format used for in memory blocks : zstd if available, then zlib.
+    // COMPRESSION_NONE if neither is, in which case blocks are copied as is
+    COMPRESSION_TYPE getBlockCompression();
+    // Compresses a block with getBlockCompression(), favoring speed
+    void compressBlock(string_view data, vector<char> &compressed);
+    // Decompresses a block of known size. Returns false if it is corrupted
+    bool decompressBlock(string_view compressed, char *data, size_t size);
+
+}
+
+#endif
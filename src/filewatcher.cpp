@@ -0,0 +1,56 @@
+/*
+ * Notification of changes to the trace file, used to follow growing traces
+ */
+#include "filewatcher.h"
+#include <chrono>
+#include <thread>
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+using namespace std;
+
+namespace sail {
+
+    FileWatcher::~FileWatcher() {
+#ifdef __linux__
+        if (inotifyFD >= 0)
+            close(inotifyFD);
+#endif
+    }
+
+    bool FileWatcher::open(const string &filename) {
+#ifdef __linux__
+        inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFD < 0)
+            return false;
+        if (inotify_add_watch(inotifyFD, filename.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+            close(inotifyFD);
+            inotifyFD = -1;
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void FileWatcher::wait(int timeoutMilliseconds) {
+#ifdef __linux__
+        if (inotifyFD >= 0) {
+            struct pollfd pollFD = { inotifyFD, POLLIN, 0 };
+            if (poll(&pollFD, 1, timeoutMilliseconds) > 0) {
+                // The events themselves are not needed, the caller checks the file size
+                char events[4096];
+                while (read(inotifyFD, events, sizeof(events)) > 0)
+                    ;
+            }
+            return;
+        }
+#endif
+        this_thread::sleep_for(chrono::milliseconds(timeoutMilliseconds));
+    }
+
+}
@@ -0,0 +1,36 @@
+/*
+ * Notification of changes to the trace file, used to follow growing traces
+ */
+#ifndef SAIL_FILEWATCHER_H
+#define SAIL_FILEWATCHER_H
+
+#include <string>
+
+using namespace std;
+
+namespace sail {
+
+    // Waits for a file to be modified. Uses inotify on Linux, and falls
+    // back to waiting for the timeout (so that callers poll) elsewhere
+    class FileWatcher {
+        private:
+            int inotifyFD = -1;
+
+        public:
+            FileWatcher() {}
+            ~FileWatcher();
+            FileWatcher(const FileWatcher &) = delete;
+            FileWatcher &operator=(const FileWatcher &) = delete;
+
+            // Starts watching the file. Returns false if change notifications
+            // are not available, in which case wait() only sleeps
+            bool open(const string &filename);
+
+            // Returns once the file may have been modified,
+            // or after timeoutMilliseconds
+            void wait(int timeoutMilliseconds);
+    };
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Fast non-cryptographic 64-bit hashing of byte strings
+ *
+ * In the style of wyhash : 16 bytes are consumed per step and mixed with
+ * a 64x64->128 bit multiply. Used for content hashes and hash tables,
+ * never for anything security related.
+ */
+#ifndef SAIL_HASH_H
+#define SAIL_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+using namespace std;
+
+namespace sail {
+
+    const uint64_t HASH_SECRET[4] = {
+        0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+        0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+    };
+
+    // Multiplies a and b and folds the 128 bit result into 64 bits
+    inline uint64_t hashMix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t product = (__uint128_t)a * b;
+        return uint64_t(product) ^ uint64_t(product >> 64);
+#else
+        uint64_t aHigh = a >> 32, aLow = uint32_t(a), bHigh = b >> 32, bLow = uint32_t(b);
+        uint64_t high = aHigh * bHigh, middle1 = aHigh * bLow, middle2 = aLow * bHigh, low = aLow * bLow;
+        uint64_t carry = (uint64_t(uint32_t(middle1)) + uint32_t(middle2) + (low >> 32)) >> 32;
+        uint64_t productHigh = high + (middle1 >> 32) + (middle2 >> 32) + carry;
+        uint64_t productLow = low + (middle1 << 32) + (middle2 << 32);
+        return productLow ^ productHigh;
+#endif
+    }
+
+    inline uint64_t hashRead64(const char *p) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t hashRead32(const char *p) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t hashBytes(const char *data, size_t length, uint64_t seed = 0) {
+        seed ^= hashMix(seed ^ HASH_SECRET[0], HASH_SECRET[1]);
+        uint64_t a, b;
+        if (length <= 16) {
+            if (length >= 4) {
+                a = (hashRead32(data) << 32) | hashRead32(data + ((length >> 3) << 2));
+                b = (hashRead32(data + length - 4) << 32) | hashRead32(data + length - 4 - ((length >> 3) << 2));
+            } else if (length > 0) {
+                a = (uint64_t(uint8_t(data[0])) << 16) | (uint64_t(uint8_t(data[length >> 1])) << 8) |
+                    uint8_t(data[length - 1]);
+                b = 0;
+            } else {
+                a = b = 0;
+            }
+        } else {
+            size_t remaining = length;
+            const char *p = data;
+            if (remaining > 48) {
+                uint64_t seed1 = seed, seed2 = seed;
+                do {
+                    seed = hashMix(hashRead64(p) ^ HASH_SECRET[1], hashRead64(p + 8) ^ seed);
+                    seed1 = hashMix(hashRead64(p + 16) ^ HASH_SECRET[2], hashRead64(p + 24) ^ seed1);
+                    seed2 = hashMix(hashRead64(p + 32) ^ HASH_SECRET[3], hashRead64(p + 40) ^ seed2);
+                    p += 48;
+                    remaining -= 48;
+                } while (remaining > 48);
+                seed ^= seed1 ^ seed2;
+            }
+            while (remaining > 16) {
+                seed = hashMix(hashRead64(p) ^ HASH_SECRET[1], hashRead64(p + 8) ^ seed);
+                p += 16;
+                remaining -= 16;
+            }
+            a = hashRead64(p + remaining - 16);
+            b = hashRead64(p + remaining - 8);
+        }
+        a ^= HASH_SECRET[1];
+        b ^= seed;
+        return hashMix(HASH_SECRET[0] ^ length, hashMix(a, b) ^ HASH_SECRET[1]);
+    }
+
+    inline uint64_t hashBytes(string_view str, uint64_t seed = 0) {
+        return hashBytes(str.data(), str.size(), seed);
+    }
+
+}
+
+#endif
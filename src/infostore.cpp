@@ -0,0 +1,319 @@
+/*
+ * Storage of the event info bodies
+ */
+#include "infostore.h"
+#include "compression.h"
+#include "hash.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+namespace sail {
+
+    // Size from which a block of bodies is compressed
+    const size_t INFO_BLOCK_SIZE = 64 << 10;
+    // Number of decompressed blocks that are kept
+    const size_t INFO_BLOCK_CACHE_SIZE = 8;
+    // Number of slots of a body table that is not empty
+    const size_t INFO_STORE_MIN_SLOTS = 64;
+    // Seeds of the hash placing a body in the slots and of its fingerprint
+    const uint64_t INFO_SLOT_SEED = 0;
+    const uint64_t INFO_FINGERPRINT_SEED = HASH_SECRET[2];
+
+    static uint64_t hashLines(const LineID *begin, const LineID *end, uint64_t seed) {
+        return hashBytes(reinterpret_cast<const char *>(begin), (end - begin) * sizeof(LineID), seed);
+    }
+
+    void InfoStore::splitLines(string_view body, vector<InfoLine> &infoLines) {
+        for (;;) {
+            size_t lineEnd = body.find('\n');
+            string_view line = body.substr(0, lineEnd);
+            infoLines.push_back(InfoLine{ line, hashBytes(line) });
+            if (lineEnd == string_view::npos)
+                break;
+            body.remove_prefix(lineEnd + 1);
+        }
+    }
+
+    LineID InfoStore::internLine(const InfoLine &line) {
+        size_t lineCount = lines.size();
+        LineID id = internTextLine(line);
+        // Point the dictionary at a copy of the line
+        if (id == lineCount)
+            lines.setName(id, lineText.copy(line.text));
+        return id;
+    }
+
+    // The lines of the text bodies are views into the mapped trace, which outlives the store
+    LineID InfoStore::internTextLine(const InfoLine &line) {
+        auto entry = lines.intern(line.text, line.hash);
+        if (entry.second && entry.first >= ~0U) {
+            cout << "Too many distinct info lines in the trace\n";
+            exit(0);
+        }
+        return entry.first;
+    }
+
+    uint64_t InfoStore::add(string_view body) {
+        newInfoLines.clear();
+        splitLines(body, newInfoLines);
+        return add(newInfoLines.data(), newInfoLines.data() + newInfoLines.size());
+    }
+
+    uint64_t InfoStore::add(const InfoLine *begin, const InfoLine *end) {
+        addedBodies++;
+        if (indexedBodies < size())
+            indexAppended();
+        if ((size() + 1) * 2 > slots.size())
+            grow();
+        newLines.clear();
+        for (const InfoLine *line = begin; line != end; line++)
+            newLines.push_back(internLine(*line));
+        const LineID *newLinesEnd = newLines.data() + newLines.size();
+        uint32_t hash = hashLines(newLines.data(), newLinesEnd, INFO_SLOT_SEED);
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            Slot &entry = slots[slot];
+            if (entry.id == FREE_SLOT) {
+                entry = Slot{ hash, uint32_t(size()) };
+                bodyKeys.push_back(getBodyKey(newLines.data(), newLinesEnd));
+                appendBody(newLines.data(), newLinesEnd);
+                indexedBodies++;
+                return entry.id;
+            }
+            if (entry.hash == hash && sameBody(entry.id, newLines.data(), newLinesEnd))
+                return entry.id;
+        }
+    }
+
+    InfoStore::BodyKey InfoStore::getBodyKey(const LineID *begin, const LineID *end) const {
+        return BodyKey{ hashLines(begin, end, INFO_FINGERPRINT_SEED), uint32_t(end - begin),
+            begin == end ? 0 : *begin };
+    }
+
+    bool InfoStore::sameBody(uint64_t body, const LineID *begin, const LineID *end) {
+        size_t lineCount;
+        const LineID *bodyLines = getResidentLines(body, lineCount);
+        if (bodyLines != nullptr)
+            return lineCount == size_t(end - begin) && equal(begin, end, bodyLines);
+        // The block of the body is compressed or spilled
+        const BodyKey &key = bodyKeys[body], newKey = getBodyKey(begin, end);
+        return key.lineCount == newKey.lineCount && key.firstLine == newKey.firstLine &&
+            key.fingerprint == newKey.fingerprint;
+    }
+
+    void InfoStore::appendBody(const LineID *begin, const LineID *end) {
+        openBodyStarts.push_back(openBlock.size());
+        openBlock.push_back(end - begin);
+        openBlock.insert(openBlock.end(), begin, end);
+        blockWordCount += (end - begin) + 1;
+        bodyCount++;
+        if (openBlock.size() * sizeof(uint32_t) >= INFO_BLOCK_SIZE)
+            closeBlock();
+    }
+
+    void InfoStore::closeBlock() {
+        Block block;
+        block.firstBody = bodyCount - openBodyStarts.size();
+        block.size = openBlock.size();
+        compressBlock(string_view(reinterpret_cast<const char *>(openBlock.data()),
+                    openBlock.size() * sizeof(uint32_t)), block.data);
+        residentBytes += block.data.size();
+        blocks.push_back(move(block));
+        openBlock.clear();
+        openBodyStarts.clear();
+        evictBlocks();
+    }
+
+    void InfoStore::setBudget(size_t bytes) {
+        budget = bytes;
+        evictBlocks();
+    }
+
+    void InfoStore::evictBlocks() {
+        // Without a spill file, the blocks stay in memory
+        if (spillFile.hasFailed())
+            return;
+        // Two turns of the clock hand clear the references of all the blocks
+        for (size_t step = 0; residentBytes > budget && step < blocks.size() * 2; step++) {
+            if (clockHand >= blocks.size())
+                clockHand = 0;
+            Block &block = blocks[clockHand++];
+            if (block.spilled)
+                continue;
+            if (block.referenced) {
+                block.referenced = false;
+                continue;
+            }
+            if (!spillFile.write(string_view(block.data.data(), block.data.size()), block.spillOffset)) {
+                cout << "Info blocks can not be spilled, the memory budget is ignored from now on\n";
+                return;
+            }
+            block.spilled = true;
+            block.spillSize = block.data.size();
+            residentBytes -= block.spillSize;
+            spilledBytes += block.spillSize;
+            vector<char>().swap(block.data);
+        }
+    }
+
+    void InfoStore::attach(const uint64_t *offsets, const LineID *lineIDs, size_t count) {
+        mappedOffsets = offsets;
+        mappedLines = lineIDs;
+        mappedBodies = count;
+        bodyCount = count;
+    }
+
+    void InfoStore::attachText(string_view text, const uint64_t *ranges, size_t count) {
+        mappedText = text;
+        mappedRanges = ranges;
+        mappedBodies = count;
+        bodyCount = count;
+    }
+
+    const InfoStore::CachedBlock &InfoStore::getBlock(size_t block) const {
+        cacheClock++;
+        CachedBlock *leastRecent = nullptr;
+        for (CachedBlock &cached : cache) {
+            if (cached.block == block) {
+                cached.lastUse = cacheClock;
+                return cached;
+            }
+            if (leastRecent == nullptr || cached.lastUse < leastRecent->lastUse)
+                leastRecent = &cached;
+        }
+        if (cache.size() < INFO_BLOCK_CACHE_SIZE) {
+            cache.emplace_back();
+            leastRecent = &cache.back();
+        }
+        CachedBlock &cached = *leastRecent;
+        const Block &compressed = blocks[block];
+        compressed.referenced = true;
+        string_view data(compressed.data.data(), compressed.data.size());
+        if (compressed.spilled) {
+            spillBuffer.resize(compressed.spillSize);
+            if (!spillFile.read(compressed.spillOffset, spillBuffer.data(), spillBuffer.size())) {
+                cout << "Unable to read info block " << block << " from the spill file\n";
+                exit(0);
+            }
+            data = string_view(spillBuffer.data(), spillBuffer.size());
+        }
+        cached.block = block;
+        cached.lastUse = cacheClock;
+        cached.words.resize(compressed.size);
+        if (!decompressBlock(data, reinterpret_cast<char *>(cached.words.data()), compressed.size * sizeof(uint32_t))) {
+            cout << "Info block " << block << " is corrupted\n";
+            exit(0);
+        }
+        cached.bodyStarts.clear();
+        for (size_t word = 0; word < cached.words.size(); word += cached.words[word] + 1)
+            cached.bodyStarts.push_back(word);
+        return cached;
+    }
+
+    const LineID *InfoStore::getLines(uint64_t body, size_t &lineCount) {
+        if (body < mappedBodies && mappedRanges != nullptr) {
+            textLines.clear();
+            splitLines(getText(body), textLines);
+            textBodyLines.clear();
+            for (const InfoLine &line : textLines)
+                textBodyLines.push_back(internTextLine(line));
+            lineCount = textBodyLines.size();
+            return textBodyLines.data();
+        }
+        if (body < mappedBodies) {
+            lineCount = mappedOffsets[body + 1] - mappedOffsets[body];
+            return mappedLines + mappedOffsets[body];
+        }
+        uint64_t firstOpenBody = bodyCount - openBodyStarts.size();
+        if (body >= firstOpenBody) {
+            const uint32_t *words = openBlock.data() + openBodyStarts[body - firstOpenBody];
+            lineCount = words[0];
+            return words + 1;
+        }
+        size_t block = findBlock(body);
+        const CachedBlock &cached = getBlock(block);
+        const uint32_t *words = cached.words.data() + cached.bodyStarts[body - blocks[block].firstBody];
+        lineCount = words[0];
+        return words + 1;
+    }
+
+    // Returns the last block that starts at or before the body
+    size_t InfoStore::findBlock(uint64_t body) const {
+        return upper_bound(blocks.begin(), blocks.end(), body, [](uint64_t value, const Block &block) {
+            return value < block.firstBody;
+        }) - blocks.begin() - 1;
+    }
+
+    // Same as getLines(), but returns nullptr rather than decompress a block
+    const LineID *InfoStore::getResidentLines(uint64_t body, size_t &lineCount) {
+        if (body < mappedBodies || body >= bodyCount - openBodyStarts.size())
+            return getLines(body, lineCount);
+        size_t block = findBlock(body);
+        for (const CachedBlock &cached : cache) {
+            if (cached.block == block) {
+                const uint32_t *words = cached.words.data() + cached.bodyStarts[body - blocks[block].firstBody];
+                lineCount = words[0];
+                return words + 1;
+            }
+        }
+        return nullptr;
+    }
+
+    string InfoStore::getBody(uint64_t body) {
+        if (body < mappedBodies && mappedRanges != nullptr)
+            return string(getText(body));
+        string text;
+        size_t lineCount;
+        const LineID *bodyLines = getLines(body, lineCount);
+        for (size_t i = 0; i < lineCount; i++) {
+            if (i > 0)
+                text += '\n';
+            text.append(getLine(bodyLines[i]));
+        }
+        return text;
+    }
+
+    void InfoStore::grow() {
+        vector<Slot> oldSlots(max(slots.size() * 2, INFO_STORE_MIN_SLOTS), Slot{ 0, FREE_SLOT });
+        oldSlots.swap(slots);
+        for (const Slot &entry : oldSlots)
+            if (entry.id != FREE_SLOT)
+                insertSlot(entry.hash, entry.id);
+    }
+
+    void InfoStore::insertSlot(uint32_t hash, uint64_t body) {
+        size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot].id != FREE_SLOT)
+            slot = (slot + 1) & mask;
+        slots[slot] = Slot{ hash, uint32_t(body) };
+    }
+
+    // Hashes the attached bodies into the slots. They are not compared
+    // with each other, a duplicate gets a slot of its own
+    void InfoStore::indexAppended() {
+        while (size() * 2 > slots.size())
+            grow();
+        bodyKeys.reserve(size());
+        for (; indexedBodies < size(); indexedBodies++) {
+            size_t lineCount;
+            const LineID *bodyLines = getLines(indexedBodies, lineCount);
+            insertSlot(uint32_t(hashLines(bodyLines, bodyLines + lineCount, INFO_SLOT_SEED)), indexedBodies);
+            bodyKeys.push_back(getBodyKey(bodyLines, bodyLines + lineCount));
+        }
+    }
+
+    size_t InfoStore::memoryUsage() const {
+        size_t bytes = lineText.memoryUsage() + lines.memoryUsage() + slots.capacity() * sizeof(Slot) +
+            bodyKeys.capacity() * sizeof(BodyKey) +
+            blocks.capacity() * sizeof(Block) + (openBlock.capacity() + openBodyStarts.capacity()) * sizeof(uint32_t) +
+            residentBytes + spillBuffer.capacity() + textLines.capacity() * sizeof(InfoLine) +
+            textBodyLines.capacity() * sizeof(LineID);
+        for (const CachedBlock &cached : cache)
+            bytes += (cached.words.capacity() + cached.bodyStarts.capacity()) * sizeof(uint32_t);
+        return bytes;
+    }
+
+}
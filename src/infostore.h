@@ -0,0 +1,201 @@
+/*
+ * Storage of the event info bodies
+ *
+ * Info bodies are mostly sets of lines such as "p -> {a, x}", and successive
+ * bodies differ in a few lines. Every distinct line is stored once in a line
+ * dictionary, and a body is stored as the sequence of its LineIDs. Bodies
+ * with the same lines are stored once as well, with a table on the hash of
+ * their LineIDs. A body whose hash matches is compared line by line if its
+ * lines are in memory (attached, in the open block or in a cached block).
+ * Finding a body never decompresses a block though : otherwise, its number
+ * of lines and first line are compared, along with a 64-bit fingerprint
+ * computed with another seed than the hash.
+ *
+ * Bodies are split on '\n' like splitOn() : a body that ends with a newline
+ * ends with an empty line, so that joining the lines gives the body back.
+ *
+ * The LineIDs of the bodies are packed into blocks of about 64 KB, which are
+ * compressed once they are full (see compressBlock()). A few decompressed
+ * blocks are kept in a least recently used cache, so that the bodies around
+ * the current event do not have to be decompressed again while scrubbing.
+ *
+ * The text of the lines added by add() is copied, so that the bodies do not
+ * refer to the trace text. The lines and bodies of a binary trace are used in
+ * place, without hashing them. The bodies of a sidecar index are kept as their
+ * range in the trace text, and are only split into lines when they are read.
+ *
+ * Under a memory budget, the compressed blocks that were not read recently
+ * are evicted to a spill file (clock algorithm : a block that was read since
+ * the last pass gets a second chance). They are read back from the file into
+ * the cache of decompressed blocks when their bodies are accessed.
+ */
+#ifndef SAIL_INFOSTORE_H
+#define SAIL_INFOSTORE_H
+
+#include "arena.h"
+#include "nametable.h"
+#include "spillfile.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    typedef uint32_t LineID;
+
+    // Line of a body along with its hash, as computed by splitLines()
+    struct InfoLine {
+        string_view text;
+        uint64_t hash;
+    };
+
+    class InfoStore {
+        private:
+            // Slots keep 32 bits of the hash, which place the body and are compared
+            // before its lines. Body IDs fit in 32 bits like the info of the events
+            struct Slot {
+                uint32_t hash;
+                // FREE_SLOT for a free slot
+                uint32_t id;
+            };
+            static const uint32_t FREE_SLOT = ~0U;
+            // Block of bodies : for every body, its number of lines followed by its LineIDs
+            struct Block {
+                uint64_t firstBody;
+                // Number of words once decompressed
+                size_t size;
+                // Compressed words, or their position in the spill file once evicted
+                vector<char> data;
+                bool spilled = false;
+                uint64_t spillOffset = 0;
+                size_t spillSize = 0;
+                // Set when the block is read, cleared by the clock hand
+                mutable bool referenced = false;
+            };
+            // Decompressed block, with the position of every body in it
+            struct CachedBlock {
+                size_t block;
+                vector<uint32_t> words;
+                vector<uint32_t> bodyStarts;
+                uint64_t lastUse;
+            };
+
+            // Line dictionary. The lines of the text bodies are interned as they are read
+            NameTable lines;
+            // Text of the lines added by add()
+            Arena lineText;
+
+            // Bodies of a binary trace, used in place : the lines of
+            // body b are mappedLines[mappedOffsets[b] .. mappedOffsets[b + 1])
+            const uint64_t *mappedOffsets = nullptr;
+            const LineID *mappedLines = nullptr;
+            size_t mappedBodies = 0;
+            // Bodies of a sidecar index, used in place instead : body b is
+            // mappedText.substr(mappedRanges[2 * b], mappedRanges[2 * b + 1])
+            string_view mappedText;
+            const uint64_t *mappedRanges = nullptr;
+            // Lines of the last text body that was read
+            vector<InfoLine> textLines;
+            vector<LineID> textBodyLines;
+            // Bodies added afterwards : the compressed blocks, then the block being filled
+            vector<Block> blocks;
+            vector<uint32_t> openBlock;
+            vector<uint32_t> openBodyStarts;
+            uint64_t bodyCount = 0;
+            // Number of words in the blocks, including the open one
+            uint64_t blockWordCount = 0;
+            mutable vector<CachedBlock> cache;
+            mutable uint64_t cacheClock = 0;
+
+            // Bytes of compressed blocks kept in memory, and the evicted ones
+            size_t budget = SIZE_MAX;
+            size_t residentBytes = 0;
+            size_t spilledBytes = 0;
+            size_t clockHand = 0;
+            mutable SpillFile spillFile;
+            mutable vector<char> spillBuffer;
+
+            // Number of slots is a power of two, at most half of them are used.
+            // Bodies of a binary trace are hashed into the slots by the next add()
+            vector<Slot> slots;
+            size_t indexedBodies = 0;
+            // What is compared of a body in the slots when its lines are not in memory
+            struct BodyKey {
+                uint64_t fingerprint;
+                uint32_t lineCount;
+                // First line, or 0 for a body without lines
+                LineID firstLine;
+            };
+            vector<BodyKey> bodyKeys;
+            // Number of bodies passed to add()
+            uint64_t addedBodies = 0;
+            // Lines and LineIDs of the body being added
+            vector<InfoLine> newInfoLines;
+            vector<LineID> newLines;
+
+            LineID internLine(const InfoLine &line);
+            LineID internTextLine(const InfoLine &line);
+            string_view getText(uint64_t body) const {
+                return mappedText.substr(mappedRanges[2 * body], mappedRanges[2 * body + 1]);
+            }
+            void appendBody(const LineID *begin, const LineID *end);
+            void closeBlock();
+            void evictBlocks();
+            size_t findBlock(uint64_t body) const;
+            const CachedBlock &getBlock(size_t block) const;
+            const LineID *getResidentLines(uint64_t body, size_t &lineCount);
+            BodyKey getBodyKey(const LineID *begin, const LineID *end) const;
+            bool sameBody(uint64_t body, const LineID *begin, const LineID *end);
+            void grow();
+            void insertSlot(uint32_t hash, uint64_t body);
+            void indexAppended();
+
+        public:
+            // Splits the body into lines and hashes them.
+            // Does not touch the store, so it can run on any thread
+            static void splitLines(string_view body, vector<InfoLine> &infoLines);
+
+            // Returns the ID of the body. Bodies with the same text get the same ID
+            uint64_t add(string_view body);
+            uint64_t add(const InfoLine *begin, const InfoLine *end);
+
+            // Loading from a binary trace : the lines get the next LineIDs and are
+            // expected to be distinct. The bodies are attached to an empty store,
+            // offsets holds count + 1 entries. Both have to outlive the store
+            LineID appendLine(string_view line)     { return lines.append(line); }
+            void attach(const uint64_t *offsets, const LineID *lineIDs, size_t count);
+            // Loading from a sidecar index : the bodies are attached to an empty store as
+            // their offset and length in the text, ranges holds 2 * count entries.
+            // Both have to outlive the store
+            void attachText(string_view text, const uint64_t *ranges, size_t count);
+
+            size_t size() const                     { return bodyCount; }
+            size_t lineCount() const                { return lines.size(); }
+            uint64_t addedCount() const             { return addedBodies; }
+
+            // Returns the LineIDs of the body and sets lineCount. They stay
+            // valid until the store changes or another body is read.
+            // Reading a body of an index interns its lines, which adds LineIDs
+            const LineID *getLines(uint64_t body, size_t &lineCount);
+            string_view getLine(LineID line) const  { return lines.getName(line); }
+            // Joins the lines of the body
+            string getBody(uint64_t body);
+
+            // Bytes used by the line text, the blocks, the cache and the tables
+            size_t memoryUsage() const;
+            // Bytes that the blocks would use without compression
+            size_t uncompressedBlockSize() const    { return blockWordCount * sizeof(uint32_t); }
+
+            // Bytes of compressed blocks to keep in memory, SIZE_MAX for all of them.
+            // Blocks are evicted right away and whenever a block is added
+            void setBudget(size_t bytes);
+            size_t blockMemoryUsage() const         { return residentBytes; }
+            size_t spilledSize() const              { return spilledBytes; }
+    };
+
+}
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * Index of the timeline events by location
+ */
+#include "locationindex.h"
+#include "hash.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace sail {
+
+    // Number of slots of a table that is not empty
+    const size_t LOCATION_INDEX_MIN_SLOTS = 64;
+    // Number of pending events below which the rows are not rebuilt before the end of the load
+    const uint64_t LOCATION_INDEX_MIN_PENDING = 1 << 16;
+
+    static uint64_t hashLocation(const EventLocation &location) {
+        return hashMix((uint64_t(location.node1) << 32 | location.node2) ^ HASH_SECRET[0],
+                location.type ^ HASH_SECRET[1]);
+    }
+
+    LocationID LocationIndex::intern(const EventLocation &location) {
+        if ((locations.size() + 1) * 2 > slots.size())
+            grow();
+        uint64_t hash = hashLocation(location);
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            Slot &entry = slots[slot];
+            if (entry.id == NOT_FOUND) {
+                entry.hash = hash;
+                entry.id = locations.size();
+                locations.push_back(location);
+                pending.emplace_back();
+                return entry.id;
+            }
+            if (entry.hash == hash && locations[entry.id] == location)
+                return entry.id;
+        }
+    }
+
+    LocationID LocationIndex::find(const EventLocation &location) const {
+        if (slots.empty())
+            return NOT_FOUND;
+        uint64_t hash = hashLocation(location);
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            const Slot &entry = slots[slot];
+            if (entry.id == NOT_FOUND)
+                return NOT_FOUND;
+            if (entry.hash == hash && locations[entry.id] == location)
+                return entry.id;
+        }
+    }
+
+    void LocationIndex::grow() {
+        vector<Slot> oldSlots(max(slots.size() * 2, LOCATION_INDEX_MIN_SLOTS), Slot{ 0, NOT_FOUND });
+        oldSlots.swap(slots);
+        size_t mask = slots.size() - 1;
+        for (const Slot &entry : oldSlots) {
+            if (entry.id == NOT_FOUND)
+                continue;
+            size_t slot = entry.hash & mask;
+            while (slots[slot].id != NOT_FOUND)
+                slot = (slot + 1) & mask;
+            slots[slot] = entry;
+        }
+    }
+
+    void LocationIndex::add(LocationID id, uint32_t eventIndex) {
+        pending[id].push_back(pendingArena, eventIndex);
+        // Rebuilding the rows when the pending events double them
+        // keeps the total cost of the compactions linear
+        if (++pendingCount >= max<uint64_t>(events.size(), LOCATION_INDEX_MIN_PENDING))
+            compact();
+    }
+
+    void LocationIndex::append(const EventLocation &location, const uint32_t *begin, const uint32_t *end) {
+        pending[intern(location)].append(pendingArena, begin, end);
+        pendingCount += end - begin;
+        if (pendingCount >= max<uint64_t>(events.size(), LOCATION_INDEX_MIN_PENDING))
+            compact();
+    }
+
+    void LocationIndex::merge(const LocationIndex &other) {
+        for (LocationID otherID = 0; otherID < other.size(); otherID++) {
+            LocationID id = intern(other.locations[otherID]);
+            pending[id].append(pendingArena, other.rowBegin(otherID), other.rowEnd(otherID));
+            pending[id].append(pendingArena, other.pending[otherID].begin(), other.pending[otherID].end());
+            pendingCount += other.getEventCount(otherID);
+        }
+        if (pendingCount >= max<uint64_t>(events.size(), LOCATION_INDEX_MIN_PENDING))
+            compact();
+    }
+
+    void LocationIndex::compact() {
+        if (pendingCount == 0)
+            return;
+        vector<uint64_t> newOffsets(locations.size() + 1);
+        vector<uint32_t> newEvents(events.size() + pendingCount);
+        uint64_t offset = 0;
+        for (LocationID id = 0; id < locations.size(); id++) {
+            newOffsets[id] = offset;
+            offset = copy(rowBegin(id), rowEnd(id), newEvents.begin() + offset) - newEvents.begin();
+            offset = copy(pending[id].begin(), pending[id].end(), newEvents.begin() + offset) - newEvents.begin();
+            pending[id].reset();
+        }
+        pendingArena.clear();
+        newOffsets[locations.size()] = offset;
+        offsets.swap(newOffsets);
+        events.swap(newEvents);
+        pendingCount = 0;
+    }
+
+    optional<uint32_t> LocationIndex::getPrevEvent(LocationID id, uint64_t eventIndex) const {
+        auto &pendingEvents = pending[id];
+        auto prev = lower_bound(pendingEvents.begin(), pendingEvents.end(), eventIndex);
+        if (prev != pendingEvents.begin())
+            return *(prev - 1);
+        const uint32_t *begin = rowBegin(id), *end = rowEnd(id);
+        const uint32_t *rowPrev = lower_bound(begin, end, eventIndex);
+        if (rowPrev == begin)
+            return nullopt;
+        return *(rowPrev - 1);
+    }
+
+    optional<uint32_t> LocationIndex::getNextEvent(LocationID id, uint64_t eventIndex) const {
+        const uint32_t *begin = rowBegin(id), *end = rowEnd(id);
+        const uint32_t *rowNext = upper_bound(begin, end, eventIndex);
+        if (rowNext != end)
+            return *rowNext;
+        auto &pendingEvents = pending[id];
+        auto next = upper_bound(pendingEvents.begin(), pendingEvents.end(), eventIndex);
+        if (next == pendingEvents.end())
+            return nullopt;
+        return *next;
+    }
+
+    size_t LocationIndex::memoryUsage() const {
+        size_t bytes = slots.capacity() * sizeof(Slot) + locations.capacity() * sizeof(EventLocation) +
+            offsets.capacity() * sizeof(uint64_t) + events.capacity() * sizeof(uint32_t) +
+            pending.capacity() * sizeof(ArenaVector<uint32_t>) + pendingArena.memoryUsage();
+        return bytes;
+    }
+
+}
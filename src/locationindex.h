@@ -0,0 +1,113 @@
+/*
+ * Index of the timeline events by location (node, edge or global)
+ *
+ * Every location gets a dense LocationID from an open addressing table.
+ * The event indices of all locations are stored in compressed sparse rows :
+ * the events of location l are events[offsets[l] .. offsets[l + 1]), sorted.
+ *
+ * The timeline grows while the trace is loaded and followed, so events are
+ * first added to a pending list of their location. The pending lists are
+ * merged into the rows once they hold as many events as the rows, and when
+ * compact() is called at the end of the load. Pending events always come
+ * after the events of the rows of the same location.
+ */
+#ifndef SAIL_LOCATIONINDEX_H
+#define SAIL_LOCATIONINDEX_H
+
+#include "arena.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    typedef uint64_t LocationID;
+
+    struct EventLocation {
+        uint32_t type;
+        uint32_t node1;
+        uint32_t node2;
+
+        bool operator==(const EventLocation &other) const {
+            return type == other.type && node1 == other.node1 && node2 == other.node2;
+        }
+    };
+
+    class LocationIndex {
+        private:
+            struct Slot {
+                uint64_t hash;
+                // NOT_FOUND for a free slot
+                LocationID id;
+            };
+
+            // Number of slots is a power of two, at most half of them are used
+            vector<Slot> slots;
+            // Location of every LocationID
+            vector<EventLocation> locations;
+            // Rows of the locations that existed at the last compaction
+            vector<uint64_t> offsets;
+            vector<uint32_t> events;
+            // Events added since the last compaction, per LocationID.
+            // The lists are stored in pendingArena, which is cleared by compact()
+            vector<ArenaVector<uint32_t>> pending;
+            Arena pendingArena;
+            uint64_t pendingCount = 0;
+
+            void grow();
+            const uint32_t *rowBegin(LocationID id) const {
+                return id + 1 < offsets.size() ? events.data() + offsets[id] : nullptr;
+            }
+            const uint32_t *rowEnd(LocationID id) const {
+                return id + 1 < offsets.size() ? events.data() + offsets[id + 1] : nullptr;
+            }
+
+        public:
+            static const LocationID NOT_FOUND = ~0ULL;
+
+            // Returns the LocationID of the location. A new location has no events
+            // until one is added to it, getEventCount() has to be checked before searching it
+            LocationID intern(const EventLocation &location);
+            // Event indices have to be added in increasing order for every location
+            void add(const EventLocation &location, uint32_t eventIndex)    { add(intern(location), eventIndex); }
+            void add(LocationID id, uint32_t eventIndex);
+            void append(const EventLocation &location, const uint32_t *begin, const uint32_t *end);
+            // Appends the events of every location of the other index.
+            // They have to come after the events of this index
+            void merge(const LocationIndex &other);
+            // Merges the pending events into the rows
+            void compact();
+
+            // Returns the LocationID of the location, or NOT_FOUND if it has no events
+            LocationID find(const EventLocation &location) const;
+            size_t size() const                                 { return locations.size(); }
+            const EventLocation &getLocation(LocationID id) const { return locations[id]; }
+            uint64_t getEventCount(LocationID id) const {
+                return (rowEnd(id) - rowBegin(id)) + pending[id].size();
+            }
+            // Calls visit(eventIndex) for the events of the location, in order
+            template <typename Visit> void forEachEvent(LocationID id, Visit visit) const {
+                for (const uint32_t *event = rowBegin(id); event != rowEnd(id); event++)
+                    visit(*event);
+                for (uint32_t event : pending[id])
+                    visit(event);
+            }
+
+            // Searches the events of the location : the last event before eventIndex,
+            // and the first event after it. nullopt if there is none
+            optional<uint32_t> getPrevEvent(LocationID id, uint64_t eventIndex) const;
+            optional<uint32_t> getNextEvent(LocationID id, uint64_t eventIndex) const;
+            // Last event of the location, which has at least one
+            uint32_t getLastEvent(LocationID id) const {
+                return pending[id].empty() ? *(rowEnd(id) - 1) : pending[id].back();
+            }
+
+            // Bytes used by the table, the rows and the pending lists
+            size_t memoryUsage() const;
+    };
+
+}
+
+#endif
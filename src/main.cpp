@@ -7,7 +7,11 @@
 #include "imgui_impl_opengl3.h"
 #include "imnodes.h"
 #include "trace.h"
+#include "benchmark.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
 #include <SDL.h>
 #if defined(IMGUI_IMPL_OPENGL_ES2)
 #include <SDL_opengles2.h>
@@ -22,11 +26,85 @@ using namespace sail;
 
 int main(int argc, char** argv)
 {
-    if (argc != 2) {
-        printf("Specify tracefile\n");
+    // Usage : sail_viewer [-j <threads>] [--benchmark] [--no-cache] [--follow] [--memory-budget <MB>] [--convert <output.sailb>] [--index] <tracefile>
+    //         sail_viewer --listen <socket>
+    // The memory budget only spills the info blocks : the graph, the events, their
+    // indices and the info line dictionary stay in memory, and are taken out of it first
+    const char *filename = nullptr;
+    const char *socketPath = nullptr;
+    const char *binaryFilename = nullptr;
+    unsigned jobs = 0;
+    bool benchmark = false;
+    bool useCache = true;
+    bool follow = false;
+    size_t memoryBudget = 0;
+    bool writeIndex = false;
+    bool validArguments = true;
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc)
+            jobs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--benchmark") == 0)
+            benchmark = true;
+        else if (strcmp(argv[i], "--no-cache") == 0)
+            useCache = false;
+        else if (strcmp(argv[i], "--follow") == 0)
+            follow = true;
+        else if (strcmp(argv[i], "--memory-budget") == 0 && i + 1 < argc)
+            memoryBudget = strtoull(argv[++i], nullptr, 10) << 20;
+        else if (strcmp(argv[i], "--convert") == 0 && i + 1 < argc)
+            binaryFilename = argv[++i];
+        else if (strcmp(argv[i], "--index") == 0)
+            writeIndex = true;
+        else if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc)
+            socketPath = argv[++i];
+        else if (filename == nullptr)
+            filename = argv[i];
+        else
+            validArguments = false;
+    }
+    // The trace is either read from a file or received on the socket
+    if (socketPath != nullptr && (filename != nullptr || benchmark || follow || binaryFilename != nullptr || writeIndex))
+        validArguments = false;
+    if (!validArguments || (filename == nullptr && socketPath == nullptr)) {
+        printf("Usage : %s [-j <threads>] [--benchmark] [--no-cache] [--follow] [--memory-budget <MB>] [--convert <output.sailb>] [--index] <tracefile>\n", argv[0]);
+        printf("        %s --listen <socket>\n", argv[0]);
+        printf("--memory-budget : info block budget, the info of the events is spilled to disk to keep the trace\n"
+               "                  within <MB>. The graph, the events and the info lines always stay in memory\n");
         exit(0);
     }
-    Trace tracefile(argv[1]);
+    if (benchmark) {
+        runBenchmarks(filename);
+        return 0;
+    }
+    // The index is written from the parsed text, never from the cache or an older index
+    unique_ptr<Trace> tracefile(socketPath != nullptr ? new Trace() : new Trace(filename, jobs, useCache && !writeIndex));
+    tracefile->setMemoryBudget(memoryBudget);
+    if (writeIndex) {
+        // Write the sidecar index of the trace and exit
+        tracefile->load();
+        if (!tracefile->writeIndex()) {
+            printf("Unable to write the index of %s\n", filename);
+            return -1;
+        }
+        printf("Wrote index %s\n", getTraceIndexPath(filename).c_str());
+        return 0;
+    }
+    if (binaryFilename != nullptr) {
+        // Convert the trace to the binary format and exit
+        tracefile->load();
+        if (!tracefile->writeBinary(binaryFilename)) {
+            printf("Unable to write %s\n", binaryFilename);
+            return -1;
+        }
+        printf("Wrote binary trace %s\n", binaryFilename);
+        return 0;
+    }
+
+    // The trace is parsed while the window opens and renders
+    if (socketPath != nullptr)
+        tracefile->listenInBackground(socketPath);
+    else
+        tracefile->loadInBackground(follow);
 
 #ifdef _WIN32
     ::SetProcessDPIAware();
@@ -133,7 +211,7 @@ int main(int argc, char** argv)
         ImGui_ImplSDL2_NewFrame();
         ImGui::NewFrame();
 
-        tracefile.render();
+        tracefile->render();
 
         ImGui::Render();
         glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
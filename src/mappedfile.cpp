@@ -0,0 +1,83 @@
+/*
+ * Read-only memory mapping of the trace file
+ */
+#include "mappedfile.h"
+#include <fstream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+namespace sail {
+
+    bool MappedFile::open(const string &filename) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = st.st_size;
+        if (length == 0) {
+            // mmap does not accept empty mappings
+            ::close(fd);
+            return true;
+        }
+        void *addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr != MAP_FAILED) {
+            // The parser walks the file front to back
+            madvise(addr, length, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(addr);
+            mapped = true;
+            return true;
+        }
+        length = 0;
+#endif
+        // Fallback : Read the whole file into memory
+        ifstream inputstream(filename, ios::binary | ios::ate);
+        if (!inputstream)
+            return false;
+        buffer.resize(inputstream.tellg());
+        inputstream.seekg(0);
+        inputstream.read(buffer.data(), buffer.size());
+        data = buffer.data();
+        length = buffer.size();
+        return true;
+    }
+
+    void MappedFile::adviseRandomAccess() {
+#ifndef _WIN32
+        if (mapped)
+            madvise(const_cast<char *>(data), length, MADV_RANDOM);
+#endif
+    }
+
+    void MappedFile::releasePages() {
+#ifndef _WIN32
+        // The mapping is private and never written, so the pages are the file contents
+        if (mapped)
+            madvise(const_cast<char *>(data), length, MADV_DONTNEED);
+#endif
+    }
+
+    void MappedFile::close() {
+#ifndef _WIN32
+        if (mapped)
+            munmap(const_cast<char *>(data), length);
+#endif
+        data = nullptr;
+        length = 0;
+        mapped = false;
+        buffer.clear();
+    }
+
+}
@@ -0,0 +1,52 @@
+/*
+ * Read-only memory mapping of the trace file
+ */
+#ifndef SAIL_MAPPEDFILE_H
+#define SAIL_MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    // Maps a file into memory so that the parsed trace can keep views into
+    // the file contents instead of owning copies of every string.
+    // On platforms without mmap, the file is read into a buffer instead.
+    class MappedFile {
+        private:
+            const char *data = nullptr;
+            size_t length = 0;
+            bool mapped = false;
+            // Fallback storage when the file could not be mapped
+            vector<char> buffer;
+
+            void close();
+
+        public:
+            MappedFile() {}
+            ~MappedFile() { close(); }
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            // Returns false if the file could not be opened
+            bool open(const string &filename);
+            // The file is mapped for a front to back read. Tells the system
+            // that it is read in no particular order instead, so that it
+            // does not read ahead around every access
+            void adviseRandomAccess();
+            // Drops the pages of the mapping from the memory of the process.
+            // They are read from the file again when they are accessed
+            void releasePages();
+
+            const char *begin() const   { return data; }
+            const char *end() const     { return data + length; }
+            size_t size() const         { return length; }
+            string_view view() const    { return string_view(data, length); }
+    };
+
+}
+
+#endif
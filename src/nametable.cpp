@@ -0,0 +1,88 @@
+/*
+ * Interned names with dense IDs
+ */
+#include "nametable.h"
+#include "hash.h"
+
+using namespace std;
+
+namespace sail {
+
+    // Number of slots of a table that is not empty
+    const size_t NAME_TABLE_MIN_SLOTS = 64;
+
+    pair<uint64_t, bool> NameTable::intern(string_view name) {
+        return intern(name, hashBytes(name));
+    }
+
+    pair<uint64_t, bool> NameTable::intern(string_view name, uint64_t hash) {
+        if (indexedCount < names.size())
+            indexAppended();
+        if ((names.size() + 1) * 2 > slots.size())
+            grow();
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            Slot &entry = slots[slot];
+            if (entry.id == NOT_FOUND) {
+                entry.hash = hash;
+                entry.id = names.size();
+                names.push_back(name);
+                indexedCount++;
+                return make_pair(entry.id, true);
+            }
+            if (entry.hash == hash && names[entry.id] == name)
+                return make_pair(entry.id, false);
+        }
+    }
+
+    uint64_t NameTable::append(string_view name) {
+        names.push_back(name);
+        return names.size() - 1;
+    }
+
+    uint64_t NameTable::find(string_view name) const {
+        if (slots.empty())
+            return NOT_FOUND;
+        uint64_t hash = hashBytes(name);
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            const Slot &entry = slots[slot];
+            if (entry.id == NOT_FOUND)
+                return NOT_FOUND;
+            if (entry.hash == hash && names[entry.id] == name)
+                return entry.id;
+        }
+    }
+
+    // Doubles the number of slots. The names are placed again from their
+    // stored hashes, without hashing them again
+    void NameTable::grow() {
+        vector<Slot> oldSlots(max(slots.size() * 2, NAME_TABLE_MIN_SLOTS), Slot{ 0, NOT_FOUND });
+        oldSlots.swap(slots);
+        size_t mask = slots.size() - 1;
+        for (const Slot &entry : oldSlots) {
+            if (entry.id == NOT_FOUND)
+                continue;
+            size_t slot = entry.hash & mask;
+            while (slots[slot].id != NOT_FOUND)
+                slot = (slot + 1) & mask;
+            slots[slot] = entry;
+        }
+    }
+
+    // Hashes the appended names into the slots. Appended names are not
+    // compared with each other, a duplicate gets a slot of its own
+    void NameTable::indexAppended() {
+        while (names.size() * 2 > slots.size())
+            grow();
+        size_t mask = slots.size() - 1;
+        for (; indexedCount < names.size(); indexedCount++) {
+            uint64_t hash = hashBytes(names[indexedCount]);
+            size_t slot = hash & mask;
+            while (slots[slot].id != NOT_FOUND)
+                slot = (slot + 1) & mask;
+            slots[slot] = Slot{ hash, indexedCount };
+        }
+    }
+
+}
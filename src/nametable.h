@@ -0,0 +1,67 @@
+/*
+ * Interned names with dense IDs
+ *
+ * Open addressing hash table with linear probing. Every slot holds the
+ * hash of its name along with the ID, so that a probe only compares the
+ * name when the hashes match. Lookups take a string_view and never
+ * allocate. The names are not copied : they have to outlive the table.
+ *
+ * Names that are known to be distinct can be appended without hashing
+ * them. They are only hashed into the table by the next intern().
+ */
+#ifndef SAIL_NAMETABLE_H
+#define SAIL_NAMETABLE_H
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    class NameTable {
+        private:
+            struct Slot {
+                uint64_t hash;
+                // NOT_FOUND for a free slot
+                uint64_t id;
+            };
+
+            // Number of slots is a power of two, at most half of them are used
+            vector<Slot> slots;
+            // Name of every ID
+            vector<string_view> names;
+            // Number of names that are in the slots
+            size_t indexedCount = 0;
+
+            void grow();
+            void indexAppended();
+
+        public:
+            static const uint64_t NOT_FOUND = ~0ULL;
+
+            // Returns the ID of the name and true if the name is new,
+            // in which case it gets the next ID
+            pair<uint64_t, bool> intern(string_view name);
+            // Same with the hash of the name, which is hashBytes(name)
+            pair<uint64_t, bool> intern(string_view name, uint64_t hash);
+            // Adds the name with the next ID without looking it up
+            uint64_t append(string_view name);
+            // Returns the ID of the name, or NOT_FOUND. Appended names
+            // are not found until the next intern()
+            uint64_t find(string_view name) const;
+
+            string_view getName(uint64_t id) const  { return names[id]; }
+            // Points the ID at another copy of its name, e.g. one that outlives the original
+            void setName(uint64_t id, string_view name) { names[id] = name; }
+            size_t size() const                     { return names.size(); }
+            size_t memoryUsage() const {
+                return slots.capacity() * sizeof(Slot) + names.capacity() * sizeof(string_view);
+            }
+    };
+
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * Minimal helpers to run work on multiple threads
+ */
+#include "parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    unsigned defaultJobs() {
+        unsigned jobs = thread::hardware_concurrency();
+        return jobs == 0 ? 1 : jobs;
+    }
+
+    // Threads that run the loops of parallelFor() along with the calling thread.
+    // They are started on first use and then wait for the next loop, so that
+    // the parser does not start and join threads for every round of chunks
+    class WorkerPool {
+        public:
+            // Runs the loop on the calling thread and jobs - 1 workers.
+            // Returns false without running it if the pool is running another loop
+            bool run(size_t count, unsigned jobs, const function<void(size_t)> &body);
+
+        private:
+            void work();
+            // Runs the loop until every index was taken
+            void runBody() {
+                for (size_t i = nextIndex++; i < count; i = nextIndex++)
+                    (*body)(i);
+            }
+
+            // Held by the thread whose loop is running
+            mutex runMutex;
+            // Protects the fields below, except nextIndex
+            mutex stateMutex;
+            condition_variable loopStarted, loopFinished;
+            vector<thread> workers;
+            // Current loop. Every loop gets a new generation,
+            // which the workers compare with the last loop they saw
+            const function<void(size_t)> *body = nullptr;
+            size_t count = 0;
+            atomic<size_t> nextIndex{0};
+            unsigned long long generation = 0;
+            // Workers that may still join the current loop, and workers running it
+            unsigned joiningWorkers = 0, busyWorkers = 0;
+    };
+
+    bool WorkerPool::run(size_t count, unsigned jobs, const function<void(size_t)> &body) {
+        unique_lock<mutex> running(runMutex, try_to_lock);
+        if (!running)
+            return false;
+        {
+            lock_guard<mutex> lock(stateMutex);
+            while (workers.size() + 1 < jobs)
+                workers.emplace_back(&WorkerPool::work, this);
+            this->body = &body;
+            this->count = count;
+            nextIndex = 0;
+            generation++;
+            joiningWorkers = jobs - 1;
+        }
+        loopStarted.notify_all();
+        runBody();
+        // Workers that did not wake up before the indices ran out stay out of the loop
+        unique_lock<mutex> lock(stateMutex);
+        joiningWorkers = 0;
+        loopFinished.wait(lock, [&]() { return busyWorkers == 0; });
+        return true;
+    }
+
+    void WorkerPool::work() {
+        unsigned long long lastGeneration = 0;
+        unique_lock<mutex> lock(stateMutex);
+        while (true) {
+            loopStarted.wait(lock, [&]() { return generation != lastGeneration; });
+            lastGeneration = generation;
+            if (joiningWorkers == 0)
+                continue;
+            joiningWorkers--;
+            busyWorkers++;
+            lock.unlock();
+            runBody();
+            lock.lock();
+            if (--busyWorkers == 0)
+                loopFinished.notify_all();
+        }
+    }
+
+    void parallelFor(size_t count, unsigned jobs, const function<void(size_t)> &body) {
+        if (jobs > count)
+            jobs = count;
+        // The pool is never destroyed : its threads only wait between loops,
+        // and the process may exit from within a loop
+        static WorkerPool &pool = *new WorkerPool();
+        if (jobs > 1 && pool.run(count, jobs, body))
+            return;
+        for (size_t i = 0; i < count; i++)
+            body(i);
+    }
+
+}
@@ -0,0 +1,25 @@
+/*
+ * Minimal helpers to run work on multiple threads
+ */
+#ifndef SAIL_PARALLEL_H
+#define SAIL_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+namespace sail {
+
+    // Number of threads to use when the user did not specify one
+    unsigned defaultJobs();
+
+    // Calls body(i) for every i in [0, count) on up to jobs threads.
+    // Returns once all the calls have completed. The threads are taken from
+    // a process wide pool, one loop at a time : a loop started while the pool
+    // is busy, from another thread or from within body, runs on the calling thread
+    void parallelFor(size_t count, unsigned jobs, const function<void(size_t)> &body);
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Tokenization of the trace file into instructions
+ */
+#include "parser.h"
+#include "scanner.h"
+
+using namespace std;
+
+namespace sail {
+
+    pair<string_view, string_view> splitOnFirst(string_view str, string_view delimiter) {
+        auto separatorPos = str.find_first_of(delimiter);
+        if (separatorPos == string_view::npos)
+            return make_pair(str, string_view());
+        else
+            return make_pair(
+                    str.substr(0, separatorPos),
+                    str.substr(separatorPos+1));
+    }
+
+    vector<string_view> splitOn(string_view str, string_view delimiter) {
+        vector<string_view> tokens;
+        auto separatorPos = str.find_first_of(delimiter);
+        while (separatorPos != string_view::npos) {
+            tokens.push_back(str.substr(0, separatorPos));
+            str.remove_prefix(separatorPos+1);
+            separatorPos = str.find_first_of(delimiter);
+        }
+        tokens.push_back(str);
+        return tokens;
+    }
+
+    string_view nextInstruction(string_view text, size_t &offset) {
+        size_t instructionStart = offset;
+        size_t instructionEnd = findInstructionBoundary(text.data(), text.size(), instructionStart);
+        if (instructionEnd == text.size()) {
+            // Last instruction : drop the newline at the end of the text
+            offset = instructionEnd;
+            if (instructionEnd > instructionStart && text[instructionEnd - 1] == '\n')
+                instructionEnd--;
+        } else {
+            offset = instructionEnd + 1;
+        }
+        return text.substr(instructionStart, instructionEnd - instructionStart);
+    }
+
+    size_t findLastInstruction(string_view text) {
+        size_t boundary = text.rfind("\n>>");
+        return boundary == string_view::npos ? 0 : boundary + 1;
+    }
+
+    vector<string_view> splitIntoChunks(string_view text, size_t count) {
+        vector<string_view> chunks;
+        size_t chunkStart = 0;
+        for (size_t i = 1; i < count && chunkStart < text.size(); i++) {
+            size_t splitPos = max(text.size() / count * i, chunkStart + 1);
+            size_t chunkEnd = findInstructionBoundary(text.data(), text.size(), splitPos - 1);
+            if (chunkEnd == text.size())
+                break;
+            chunks.push_back(text.substr(chunkStart, chunkEnd + 1 - chunkStart));
+            chunkStart = chunkEnd + 1;
+        }
+        if (chunkStart < text.size())
+            chunks.push_back(text.substr(chunkStart));
+        return chunks;
+    }
+
+    Instruction parseInstruction(string_view instructionText) {
+        Instruction instruction;
+        const char *text = instructionText.data();
+        size_t size = instructionText.size();
+
+        // The header tokens are separated by a single space or tab,
+        // and the header ends at the first newline
+        size_t separator = findSeparator(text, size, 0);
+        instruction.keyword = instructionText.substr(0, separator);
+
+        size_t tagArguments = 0;
+        if (instruction.keyword == ">>node") {
+            instruction.type = INSTR_NODE;
+        } else if (instruction.keyword == ">>edge") {
+            instruction.type = INSTR_EDGE;
+        } else if (instruction.keyword == ">>nodeinfo") {
+            instruction.type = INSTR_NODEINFO;
+            tagArguments = 1;
+        } else if (instruction.keyword == ">>edgeinfo") {
+            instruction.type = INSTR_EDGEINFO;
+            tagArguments = 2;
+        } else if (instruction.keyword == ">>globalinfo") {
+            instruction.type = INSTR_GLOBALINFO;
+        } else if (instruction.keyword == ">>prevnodeinfo") {
+            instruction.type = INSTR_PREVNODEINFO;
+            tagArguments = 1;
+        } else if (instruction.keyword == ">>prevedgeinfo") {
+            instruction.type = INSTR_PREVEDGEINFO;
+            tagArguments = 2;
+        } else if (instruction.keyword == ">>prevglobalinfo") {
+            instruction.type = INSTR_PREVGLOBALINFO;
+        } else {
+            instruction.type = INSTR_UNKNOWN;
+        }
+
+        // The tag is the remainder of the header after the node arguments
+        size_t tagStart = string_view::npos;
+        instruction.argumentCount = 0;
+        while (separator < size && text[separator] != '\n') {
+            size_t tokenStart = separator + 1;
+            if (instruction.argumentCount == tagArguments)
+                tagStart = tokenStart;
+            separator = findSeparator(text, size, tokenStart);
+            if (instruction.argumentCount < 2)
+                instruction.arguments[instruction.argumentCount] =
+                    instructionText.substr(tokenStart, separator - tokenStart);
+            instruction.argumentCount++;
+        }
+
+        size_t headerEnd = separator;
+        instruction.header = instructionText.substr(0, headerEnd);
+        if (headerEnd < size)
+            instruction.body = instructionText.substr(headerEnd + 1);
+        if (tagStart != string_view::npos)
+            instruction.tag = instructionText.substr(tagStart, headerEnd - tagStart);
+        return instruction;
+    }
+
+}
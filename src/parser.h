@@ -0,0 +1,58 @@
+/*
+ * Tokenization of the trace file into instructions
+ */
+#ifndef SAIL_PARSER_H
+#define SAIL_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace sail {
+
+    enum INSTRUCTION_TYPE {
+        INSTR_NODE, INSTR_EDGE,
+        INSTR_NODEINFO, INSTR_EDGEINFO, INSTR_GLOBALINFO,
+        INSTR_PREVNODEINFO, INSTR_PREVEDGEINFO, INSTR_PREVGLOBALINFO,
+        INSTR_UNKNOWN
+    };
+
+    // A tokenized instruction. All the fields are views into the trace text
+    struct Instruction {
+        INSTRUCTION_TYPE type;
+        string_view keyword;
+        string_view header;
+        string_view body;
+        // Node name arguments (source and destination for edges)
+        string_view arguments[2];
+        // Number of tokens following the keyword in the header
+        size_t argumentCount;
+        // Optional tag following the arguments
+        string_view tag;
+    };
+
+    // Splits the given string into two on the first occurrence of delimiter
+    pair<string_view, string_view> splitOnFirst(string_view str, string_view delimiter);
+    // Splits the given string on delimiter
+    vector<string_view> splitOn(string_view str, string_view delimiter);
+
+    // Returns the instruction starting at offset in text and advances offset
+    // to the start of the following instruction. An instruction extends up
+    // to the next line that starts with ">>"
+    string_view nextInstruction(string_view text, size_t &offset);
+
+    // Returns the offset of the start of the last instruction in text.
+    // Used when the text may end with an instruction that is not complete yet
+    size_t findLastInstruction(string_view text);
+
+    // Splits text into at most count pieces that start on instruction boundaries
+    vector<string_view> splitIntoChunks(string_view text, size_t count);
+
+    // Tokenizes the header of the instruction and separates the body
+    Instruction parseInstruction(string_view instructionText);
+
+}
+
+#endif
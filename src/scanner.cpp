@@ -0,0 +1,195 @@
+/*
+ * Vectorized scanning of the trace text
+ */
+#include "scanner.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SAIL_SCANNER_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)
+// AVX2 is compiled for the scanner functions only and selected at runtime
+#define SAIL_SCANNER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+namespace sail {
+
+    static inline unsigned countTrailingZeros(unsigned mask) {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        unsigned count = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            count++;
+        }
+        return count;
+#endif
+    }
+
+    // Scalar implementation
+
+    static size_t findInstructionBoundaryScalar(const char *data, size_t size, size_t from) {
+        while (from + 2 < size) {
+            const char *newline = static_cast<const char *>(memchr(data + from, '\n', size - from - 2));
+            if (newline == nullptr)
+                break;
+            from = newline - data;
+            if (data[from + 1] == '>' && data[from + 2] == '>')
+                return from;
+            from++;
+        }
+        return size;
+    }
+
+    static size_t findSeparatorScalar(const char *data, size_t size, size_t from) {
+        for (; from < size; from++)
+            if (data[from] == ' ' || data[from] == '\t' || data[from] == '\n')
+                return from;
+        return size;
+    }
+
+#ifdef SAIL_SCANNER_SSE2
+    // SSE2 implementation : "\n>>" is found by comparing three overlapping
+    // loads against '\n', '>' and '>' and combining the results
+
+    static size_t findInstructionBoundarySSE2(const char *data, size_t size, size_t from) {
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i arrow = _mm_set1_epi8('>');
+        for (; from + 2 + 16 <= size; from += 16) {
+            const char *p = data + from;
+            __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), newline);
+            __m128i second = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 1)), arrow);
+            __m128i third = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 2)), arrow);
+            unsigned mask = _mm_movemask_epi8(_mm_and_si128(first, _mm_and_si128(second, third)));
+            if (mask)
+                return from + countTrailingZeros(mask);
+        }
+        return findInstructionBoundaryScalar(data, size, from);
+    }
+
+    static size_t findSeparatorSSE2(const char *data, size_t size, size_t from) {
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (; from + 16 <= size; from += 16) {
+            __m128i chars = _mm_loadu_si128((const __m128i *)(data + from));
+            __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(chars, space),
+                    _mm_or_si128(_mm_cmpeq_epi8(chars, tab), _mm_cmpeq_epi8(chars, newline)));
+            unsigned mask = _mm_movemask_epi8(matches);
+            if (mask)
+                return from + countTrailingZeros(mask);
+        }
+        return findSeparatorScalar(data, size, from);
+    }
+#endif
+
+#ifdef SAIL_SCANNER_AVX2
+    __attribute__((target("avx2")))
+    static size_t findInstructionBoundaryAVX2(const char *data, size_t size, size_t from) {
+        const __m256i newline = _mm256_set1_epi8('\n');
+        const __m256i arrow = _mm256_set1_epi8('>');
+        for (; from + 2 + 32 <= size; from += 32) {
+            const char *p = data + from;
+            __m256i first = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), newline);
+            __m256i second = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 1)), arrow);
+            __m256i third = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 2)), arrow);
+            unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(first, _mm256_and_si256(second, third)));
+            if (mask)
+                return from + countTrailingZeros(mask);
+        }
+        return findInstructionBoundaryScalar(data, size, from);
+    }
+
+    __attribute__((target("avx2")))
+    static size_t findSeparatorAVX2(const char *data, size_t size, size_t from) {
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i newline = _mm256_set1_epi8('\n');
+        for (; from + 32 <= size; from += 32) {
+            __m256i chars = _mm256_loadu_si256((const __m256i *)(data + from));
+            __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(chars, space),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(chars, tab), _mm256_cmpeq_epi8(chars, newline)));
+            unsigned mask = _mm256_movemask_epi8(matches);
+            if (mask)
+                return from + countTrailingZeros(mask);
+        }
+        return findSeparatorScalar(data, size, from);
+    }
+#endif
+
+    // Runtime selection
+
+    typedef size_t (*ScanFunction)(const char *, size_t, size_t);
+    static ScanFunction boundaryScanner = findInstructionBoundaryScalar;
+    static ScanFunction separatorScanner = findSeparatorScalar;
+    static SCANNER_KIND currentScanner = SCANNER_SCALAR;
+
+    static bool isSupported(SCANNER_KIND kind) {
+        switch (kind) {
+            case SCANNER_SCALAR:
+                return true;
+#ifdef SAIL_SCANNER_SSE2
+            case SCANNER_SSE2:
+                return true;
+#endif
+#ifdef SAIL_SCANNER_AVX2
+            case SCANNER_AVX2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    bool setScanner(SCANNER_KIND kind) {
+        if (!isSupported(kind))
+            return false;
+        switch (kind) {
+#ifdef SAIL_SCANNER_SSE2
+            case SCANNER_SSE2:
+                boundaryScanner = findInstructionBoundarySSE2;
+                separatorScanner = findSeparatorSSE2;
+                break;
+#endif
+#ifdef SAIL_SCANNER_AVX2
+            case SCANNER_AVX2:
+                boundaryScanner = findInstructionBoundaryAVX2;
+                separatorScanner = findSeparatorAVX2;
+                break;
+#endif
+            default:
+                boundaryScanner = findInstructionBoundaryScalar;
+                separatorScanner = findSeparatorScalar;
+                break;
+        }
+        currentScanner = kind;
+        return true;
+    }
+
+    SCANNER_KIND getScanner() {
+        return currentScanner;
+    }
+
+    const char *getScannerName(SCANNER_KIND kind) {
+        switch (kind) {
+            case SCANNER_SSE2:  return "SSE2";
+            case SCANNER_AVX2:  return "AVX2";
+            default:            return "scalar";
+        }
+    }
+
+    // Picks the best implementation before main() runs
+    static bool scannerInitialized = setScanner(SCANNER_AVX2) || setScanner(SCANNER_SSE2);
+
+    size_t findInstructionBoundary(const char *data, size_t size, size_t from) {
+        return boundaryScanner(data, size, from);
+    }
+
+    size_t findSeparator(const char *data, size_t size, size_t from) {
+        return separatorScanner(data, size, from);
+    }
+
+}
@@ -0,0 +1,35 @@
+/*
+ * Vectorized scanning of the trace text
+ *
+ * The parser only needs to find two things in the trace : the start of
+ * the next instruction (a newline followed by ">>") and the separators in
+ * an instruction header (space, tab, and the newline that ends it).
+ * Both are searched 16 (SSE2) or 32 (AVX2) bytes at a time, with a scalar
+ * fallback for other architectures. The implementation is chosen at
+ * startup based on the CPU.
+ */
+#ifndef SAIL_SCANNER_H
+#define SAIL_SCANNER_H
+
+#include <cstddef>
+
+namespace sail {
+
+    enum SCANNER_KIND { SCANNER_SCALAR, SCANNER_SSE2, SCANNER_AVX2 };
+
+    // Returns the position of the first "\n>>" at or after from, or size if there is none
+    size_t findInstructionBoundary(const char *data, size_t size, size_t from);
+
+    // Returns the position of the first space, tab or newline at or after from,
+    // or size if there is none
+    size_t findSeparator(const char *data, size_t size, size_t from);
+
+    // Selects the implementation used by the functions above.
+    // Returns false if it is not supported on this machine
+    bool setScanner(SCANNER_KIND kind);
+    SCANNER_KIND getScanner();
+    const char *getScannerName(SCANNER_KIND kind);
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Temporary file that data evicted from memory is written to
+ */
+#include "spillfile.h"
+#include <filesystem>
+#include <iostream>
+#include <vector>
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace sail {
+
+    SpillFile::~SpillFile() {
+        if (file != nullptr)
+            fclose(file);
+    }
+
+    static bool seekTo(FILE *file, uint64_t offset) {
+#ifdef _WIN32
+        return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+        return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    bool SpillFile::write(string_view data, uint64_t &offset) {
+        if (failed)
+            return false;
+        if (file == nullptr) {
+#ifdef _WIN32
+            // Removed by the C library when it is closed or the process exits
+            file = tmpfile();
+#else
+            // The name is made unique by mkstemp, and the file is unlinked right away,
+            // so that it disappears with the process however it exits
+            error_code error;
+            filesystem::path directory = filesystem::temp_directory_path(error);
+            path = (directory / "sail-XXXXXX").string();
+            vector<char> name(path.begin(), path.end());
+            name.push_back('\0');
+            int fd = error ? -1 : mkstemp(name.data());
+            if (fd >= 0) {
+                path = name.data();
+                unlink(name.data());
+                file = fdopen(fd, "w+b");
+                if (file == nullptr)
+                    close(fd);
+            }
+#endif
+            if (file == nullptr) {
+                cout << "Unable to create the spill file " << path << "\n";
+                failed = true;
+                return false;
+            }
+        }
+        if (!seekTo(file, fileSize) || fwrite(data.data(), 1, data.size(), file) != data.size() || fflush(file) != 0) {
+            cout << "Unable to write to the spill file " << path << "\n";
+            failed = true;
+            return false;
+        }
+        offset = fileSize;
+        fileSize += data.size();
+        return true;
+    }
+
+    bool SpillFile::read(uint64_t offset, char *data, size_t size) {
+        if (file == nullptr || offset + size > fileSize)
+            return false;
+        return seekTo(file, offset) && fread(data, 1, size, file) == size;
+    }
+
+}
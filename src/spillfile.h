@@ -0,0 +1,49 @@
+/*
+ * Temporary file that data evicted from memory is written to
+ *
+ * The file is created on the first write in the temporary directory, and
+ * removed from it right away, so that it is released when the SpillFile is
+ * destroyed or the process exits. Data is only appended : every write
+ * returns the offset to read it back from.
+ */
+#ifndef SAIL_SPILLFILE_H
+#define SAIL_SPILLFILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace sail {
+
+    class SpillFile {
+        private:
+            // Name of the file, for the messages
+            string path;
+            FILE *file = nullptr;
+            uint64_t fileSize = 0;
+            // Set once the file could not be created or written
+            bool failed = false;
+
+        public:
+            SpillFile() {}
+            ~SpillFile();
+            SpillFile(const SpillFile &) = delete;
+            SpillFile &operator=(const SpillFile &) = delete;
+
+            // Appends the data and sets offset to its position.
+            // Returns false if the file could not be written
+            bool write(string_view data, uint64_t &offset);
+            // Returns false if the data could not be read back
+            bool read(uint64_t offset, char *data, size_t size);
+
+            uint64_t size() const   { return fileSize; }
+            // Returns true once the file could not be created or written
+            bool hasFailed() const  { return failed; }
+    };
+
+}
+
+#endif
@@ -2,157 +2,243 @@
  * Trace file parsing, traversal and rendering
  */
 #include "trace.h"
+#include "parallel.h"
+#include "scanner.h"
 #include "imnodes.h"
 #include <iostream>
-#include <fstream>
 #include <regex>
+#include <chrono>
+#include <cstdio>
 #include <gvc.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 #define STR(v) const_cast<char *>(v)
 
 using namespace std;
 
 namespace sail {
 
-    // Splits the given string into two on the first occurrence of delimiter
-    pair<string, string> splitOnFirst(string str, string delimiter) {
-        auto separatorPos = str.find_first_of(delimiter);
-        if (separatorPos == string::npos)
-            return make_pair(str,"");
-        else
-            return make_pair(
-                    str.substr(0, separatorPos),
-                    str.substr(separatorPos+1));
+    // Splits [<groupname>:]<nodename> into the group name and the node name
+    pair<string_view, string_view> splitNodeName(string_view nodeName) {
+        auto splitName = splitOnFirst(nodeName, ":");
+        if (splitName.second == "" && splitName.first != "")
+            return make_pair(string_view(), splitName.first);
+        return splitName;
     }
 
-    // Splits the given string on delimiter
-    vector<string> splitOn(string str, string delimiter) {
-        vector<string> tokens;
-        auto separatorPos = str.find_first_of(delimiter);
-        while (separatorPos != string::npos) {
-            tokens.push_back(str.substr(0, separatorPos));
-            str = str.substr(separatorPos+1);
-            separatorPos = str.find_first_of(delimiter);
-        }
-        tokens.push_back(str);
-        return tokens;
+    void Graph::addNode(string_view nodeName, string_view nodeContent) {
+        addNode(getNodeID(nodeName), nodeContent);
     }
 
-    void Graph::addNode(string nodeName, std::string nodeContent) {
-        auto splitName = splitOnFirst(nodeName, ":");
-        string groupName = splitName.first;
-        string subNodeName = splitName.second;
-        if (subNodeName == "" && groupName != "") {
-            subNodeName = groupName;
-            groupName = "";
-        }
-
-        if (nodeIDs.find(groupName) == nodeIDs.end())
-            nodeIDs[groupName];
-        if (nodeIDs[groupName].find(subNodeName) != nodeIDs[groupName].end()) {
-            NodeID nodeID = nodeIDs[groupName][subNodeName];
-            if (nodeContents.find(nodeID) != nodeContents.end()) {
-                cout << "Node " << nodeName << " is already defined with content\n" <<
-                    nodeContents[nodeID] << "\nFound redefinition\n";
-                exit(0);
-            }
-            nodeContents[nodeID] = nodeContent;
-            return;
+    void Graph::addNode(NodeID nodeID, string_view nodeContent) {
+        if (nodeContents.find(nodeID) != nodeContents.end()) {
+            cout << "Node " << nodeNames.getName(nodeID) << " is already defined with content\n" <<
+                nodeContents[nodeID] << "\nFound redefinition\n";
+            exit(0);
         }
-        NodeID nodeID = nodeNames.size();
-        nodeNames.push_back(nodeName);
-        nodeIDs[groupName][subNodeName] = nodeID;
-        nodeContents[nodeID] = nodeContent;
+        nodeContents[nodeID] = copyStrings ? streamedText.copy(nodeContent) : nodeContent;
+        contentBytes += nodeContent.size();
     }
 
-    void Graph::addEdge(string srcNodeName, string dstNodeName) {
+    void Graph::addEdge(string_view srcNodeName, string_view dstNodeName) {
         NodeID srcNodeID = getNodeID(srcNodeName);
         NodeID dstNodeID = getNodeID(dstNodeName);
-        if (edges.find(srcNodeID) == edges.end())
-            edges[srcNodeID];
-        if (edges[srcNodeID].find(dstNodeID) == edges[srcNodeID].end())
-            edges[srcNodeID].insert(dstNodeID);
+        addEdge(srcNodeID, dstNodeID);
     }
 
-    // Returns the ID for the given node.
-    // If the node has not been seen before, a new ID is assigned
-    NodeID Graph::getNodeID(string nodeName) {
-        auto splitName = splitOnFirst(nodeName, ":");
-        string groupName = splitName.first;
-        string subNodeName = splitName.second;
-        if (subNodeName == "" && groupName != "") {
-            subNodeName = groupName;
-            groupName = "";
+    void Graph::addEdge(NodeID srcNodeID, NodeID dstNodeID) {
+        // Edges in the rows are not added again, repeated pending ones are removed by compact()
+        if (srcNodeID < nodePositions.size()) {
+            auto rowBegin = edgeTargets.begin() + edgeOffsets[nodePositions[srcNodeID]];
+            auto rowEnd = edgeTargets.begin() + edgeOffsets[nodePositions[srcNodeID] + 1];
+            if (binary_search(rowBegin, rowEnd, dstNodeID))
+                return;
         }
+        pendingEdges.push_back(make_pair(srcNodeID, dstNodeID));
+        compactIfNeeded();
+    }
+
+    // Number of pending nodes and edges below which the rows are not rebuilt before the end of the load
+    const size_t GRAPH_MIN_PENDING = 1 << 16;
+
+    void Graph::compactIfNeeded() {
+        // Rebuilding the rows when the pending nodes and edges double them
+        // keeps the total cost of the compactions linear
+        if (pendingNodes.size() + pendingEdges.size() >= max(groupNodes.size() + edgeTargets.size(), GRAPH_MIN_PENDING))
+            compact();
+    }
+
+    void Graph::compact() {
+        if (pendingNodes.empty() && pendingEdges.empty())
+            return;
+        vector<pair<NodeID, NodeID>> allEdges;
+        allEdges.reserve(edgeTargets.size() + pendingEdges.size());
+        for (uint64_t position = 0; position < groupNodes.size(); position++)
+            for (uint64_t edge = edgeOffsets[position]; edge < edgeOffsets[position + 1]; edge++)
+                allEdges.push_back(make_pair(groupNodes[position], edgeTargets[edge]));
+        allEdges.insert(allEdges.end(), pendingEdges.begin(), pendingEdges.end());
+        vector<NodeID>().swap(pendingNodes);
+        vector<pair<NodeID, NodeID>>().swap(pendingEdges);
 
-        if (nodeIDs.find(groupName) == nodeIDs.end())
-            nodeIDs[groupName];
-        if (nodeIDs[groupName].find(subNodeName) == nodeIDs[groupName].end()) {
-            // Node not seen before, create a new node
-            NodeID nodeID = nodeNames.size();
-            nodeNames.push_back(nodeName);
-            nodeIDs[groupName][subNodeName] = nodeID;
-            return nodeID;
+        // Counting sort of the nodes by group, which keeps them in NodeID order within a group
+        size_t nodeCount = nodeGroups.size();
+        groupOffsets.assign(groupNames.size() + 1, 0);
+        for (GroupID groupID : nodeGroups)
+            groupOffsets[groupID + 1]++;
+        for (GroupID groupID = 0; groupID < groupNames.size(); groupID++)
+            groupOffsets[groupID + 1] += groupOffsets[groupID];
+        vector<uint64_t> nextPosition(groupOffsets.begin(), groupOffsets.end() - 1);
+        groupNodes.resize(nodeCount);
+        nodePositions.resize(nodeCount);
+        for (NodeID nodeID = 0; nodeID < nodeCount; nodeID++) {
+            uint64_t position = nextPosition[nodeGroups[nodeID]]++;
+            groupNodes[position] = nodeID;
+            nodePositions[nodeID] = position;
         }
-        return nodeIDs[groupName][subNodeName];
+
+        // Successor rows, in the order of the positions of the sources
+        sort(allEdges.begin(), allEdges.end(), [this](const pair<NodeID, NodeID> &a, const pair<NodeID, NodeID> &b) {
+            if (a.first != b.first)
+                return nodePositions[a.first] < nodePositions[b.first];
+            return a.second < b.second;
+        });
+        allEdges.erase(unique(allEdges.begin(), allEdges.end()), allEdges.end());
+        edgeOffsets.assign(nodeCount + 1, 0);
+        edgeTargets.resize(allEdges.size());
+        edgeSources.resize(allEdges.size());
+        for (size_t edge = 0; edge < allEdges.size(); edge++) {
+            edgeOffsets[nodePositions[allEdges[edge].first] + 1]++;
+            edgeTargets[edge] = allEdges[edge].second;
+            edgeSources[edge] = allEdges[edge].first;
+        }
+        for (uint64_t position = 0; position < nodeCount; position++)
+            edgeOffsets[position + 1] += edgeOffsets[position];
+
+        // Predecessor rows, with the sources in the order of their positions
+        predecessorOffsets.assign(nodeCount + 1, 0);
+        predecessorSources.resize(allEdges.size());
+        for (auto &edge : allEdges)
+            predecessorOffsets[nodePositions[edge.second] + 1]++;
+        for (uint64_t position = 0; position < nodeCount; position++)
+            predecessorOffsets[position + 1] += predecessorOffsets[position];
+        nextPosition.assign(predecessorOffsets.begin(), predecessorOffsets.end() - 1);
+        for (auto &edge : allEdges)
+            predecessorSources[nextPosition[nodePositions[edge.second]]++] = edge.first;
     }
 
-    string Graph::getNodeName(NodeID nodeID) {
-        return nodeNames[nodeID];
+    // Tree nodes are counted with their three links and color
+    const size_t TREE_NODE_OVERHEAD = 32;
+
+    size_t Graph::memoryUsage() {
+        size_t bytes = nodeNames.memoryUsage() + groupNames.memoryUsage() + nodeGroups.capacity() * sizeof(GroupID) +
+            streamedText.memoryUsage();
+        bytes += nodeContents.size() * (sizeof(pair<const NodeID, string_view>) + TREE_NODE_OVERHEAD);
+        bytes += (groupOffsets.capacity() + nodePositions.capacity() + edgeOffsets.capacity() +
+                predecessorOffsets.capacity()) * sizeof(uint64_t) +
+            (groupNodes.capacity() + edgeTargets.capacity() + edgeSources.capacity() + predecessorSources.capacity() +
+                pendingNodes.capacity()) * sizeof(NodeID) +
+            pendingEdges.capacity() * sizeof(pair<NodeID, NodeID>);
+        return bytes;
     }
 
-    string Graph::getNodeGroupName(NodeID nodeID) {
-        auto splitName = splitOnFirst(nodeNames[nodeID], ":");
-        string groupName = splitName.first;
-        string subNodeName = splitName.second;
-        if (subNodeName == "" && groupName != "") {
-            subNodeName = groupName;
-            groupName = "";
+    // Names without a group may be written with a leading ':'.
+    // Returns the name that identifies the node, without it
+    static string_view internedNodeName(string_view nodeName) {
+        if (!nodeName.empty() && nodeName[0] == ':' && nodeName.find(':', 1) == string_view::npos)
+            return nodeName.substr(1);
+        return nodeName;
+    }
+
+    // Returns the ID for the given node.
+    // If the node has not been seen before, a new ID is assigned
+    NodeID Graph::getNodeID(string_view nodeName) {
+        auto node = nodeNames.intern(internedNodeName(nodeName));
+        if (node.second) {
+            if (copyStrings)
+                nodeNames.setName(node.first, streamedText.copy(nodeNames.getName(node.first)));
+            // Node not seen before, add it to its group
+            auto group = groupNames.intern(splitNodeName(nodeNames.getName(node.first)).first);
+            nodeGroups.push_back(group.first);
+            pendingNodes.push_back(node.first);
+            compactIfNeeded();
         }
-        return groupName;
+        return node.first;
+    }
+
+    GroupID Graph::getGroupID(string_view groupName) {
+        uint64_t groupID = groupNames.find(groupName);
+        return groupID == NameTable::NOT_FOUND ? NO_GROUP : groupID;
     }
 
-    string Graph::getNodeContents(NodeID nodeID) {
-        return nodeContents[nodeID];
+    string_view Graph::getNodeName(NodeID nodeID) {
+        return nodeNames.getName(nodeID);
     }
 
-    pair<NodeID, NodeID> Graph::getLink(EdgeID linkID) {
-        return linkIDToNodeIDMap[linkID];
+    string_view Graph::getNodeContents(NodeID nodeID) {
+        auto contents = nodeContents.find(nodeID);
+        if (contents == nodeContents.end())
+            return string_view();
+        return contents->second;
     }
 
-    vector<NodeID> Graph::getActiveNodeIDs(string currentGroup) {
-        vector<NodeID> activeNodes;
-        for (auto entry: nodeIDs[currentGroup])
-            activeNodes.push_back(entry.second);
-        return activeNodes;
+    EdgeID Graph::findLink(NodeID srcNodeID, NodeID dstNodeID) {
+        if (srcNodeID < nodePositions.size()) {
+            auto rowBegin = edgeTargets.begin() + edgeOffsets[nodePositions[srcNodeID]];
+            auto rowEnd = edgeTargets.begin() + edgeOffsets[nodePositions[srcNodeID] + 1];
+            auto edge = lower_bound(rowBegin, rowEnd, dstNodeID);
+            if (edge != rowEnd && *edge == dstNodeID)
+                return edge - edgeTargets.begin();
+        }
+        for (size_t edge = 0; edge < pendingEdges.size(); edge++)
+            if (pendingEdges[edge] == make_pair(srcNodeID, dstNodeID))
+                return edgeTargets.size() + edge;
+        return NO_LINK;
     }
 
-    vector<pair<NodeID, NodeID>> Graph::getActiveEdges(string currentGroup) {
-        vector<pair<NodeID,NodeID>> activeEdges;
-        for (auto entry: nodeIDs[currentGroup])
-            for (NodeID dstNodeID : edges[entry.second])
-                activeEdges.push_back(make_pair(entry.second, dstNodeID));
-        return activeEdges;
+    size_t Graph::getActiveNodeCount(GroupID currentGroup) {
+        size_t count = 0;
+        if (currentGroup != NO_GROUP && currentGroup + 1 < groupOffsets.size())
+            count = groupOffsets[currentGroup + 1] - groupOffsets[currentGroup];
+        for (NodeID nodeID : pendingNodes)
+            count += nodeGroups[nodeID] == currentGroup;
+        return count;
     }
 
-    void Graph::renderGraphView(string currentGroup, Event currentEvent) {
-        static AttributeID attrID = 0;
+    size_t Graph::getActiveEdgeCount(GroupID currentGroup) {
+        size_t count = 0;
+        if (currentGroup != NO_GROUP && currentGroup + 1 < groupOffsets.size())
+            count = edgeOffsets[groupOffsets[currentGroup + 1]] - edgeOffsets[groupOffsets[currentGroup]];
+        for (auto &edge : pendingEdges)
+            count += nodeGroups[edge.first] == currentGroup;
+        return count;
+    }
+
+    void Graph::renderGraphView(GroupID currentGroup, Event currentEvent) {
         ImNodes::BeginNodeEditor();
-        for (NodeID nodeID : getActiveNodeIDs(currentGroup)) {
+        forEachActiveNode(currentGroup, [&](NodeID nodeID) {
             ImNodes::BeginNode(nodeID);
-            ImGui::Text(getNodeContents(nodeID).c_str());
-            if (inputAttributeIDMap.find(nodeID) == inputAttributeIDMap.end())
-                inputAttributeIDMap[nodeID] = attrID++;
-            if (outputAttributeIDMap.find(nodeID) == outputAttributeIDMap.end())
-                outputAttributeIDMap[nodeID] = attrID++;
-            ImNodes::BeginInputAttribute(inputAttributeIDMap[nodeID]);
+            string_view contents = getNodeContents(nodeID);
+            ImGui::TextUnformatted(contents.data(), contents.data() + contents.size());
+            ImNodes::BeginInputAttribute(inputAttributeID(nodeID));
             ImNodes::EndInputAttribute();
-            ImNodes::BeginOutputAttribute(outputAttributeIDMap[nodeID]);
+            ImNodes::BeginOutputAttribute(outputAttributeID(nodeID));
             ImNodes::EndOutputAttribute();
             ImNodes::EndNode();
-        }
+        });
 
-        if (lastDisplayedGroup != currentGroup) {
+        // Layout the group when it is displayed, and again when nodes or edges
+        // are added to it while the trace is loaded (at most once a second)
+        auto now = chrono::steady_clock::now();
+        bool groupChanged = lastDisplayedGroup != currentGroup;
+        size_t activeNodeCount = getActiveNodeCount(currentGroup);
+        size_t activeEdgeCount = getActiveEdgeCount(currentGroup);
+        bool groupGrew = activeNodeCount != lastLayoutNodeCount || activeEdgeCount != lastLayoutEdgeCount;
+        if (groupChanged || (groupGrew && now - lastLayoutTime >= chrono::seconds(1))) {
             lastDisplayedGroup = currentGroup;
+            lastLayoutNodeCount = activeNodeCount;
+            lastLayoutEdgeCount = activeEdgeCount;
+            lastLayoutTime = now;
 
             GVC_t* gvc = gvContext();
             Agraph_t* G = agopen(STR("graph"), Agdirected, nullptr);
@@ -166,26 +252,29 @@ namespace sail {
             // Construct the Agraph from our graph representation
             map<NodeID, Agnode_t*> nodeMap;
             map<pair<NodeID,NodeID>, Agedge_t*> edgeMap;
-            for (NodeID nodeID : getActiveNodeIDs(currentGroup))
+            forEachActiveNode(currentGroup, [&](NodeID nodeID) {
                 nodeMap[nodeID] = agnode(G, nullptr, true);
-            for (auto edge : getActiveEdges(currentGroup))
-                edgeMap[edge] = agedge(G, nodeMap[edge.first], nodeMap[edge.second], nullptr, true);
-            for (NodeID nodeID : getActiveNodeIDs(currentGroup)) {
+            });
+            forEachActiveEdge(currentGroup, [&](EdgeID, NodeID srcNodeID, NodeID dstNodeID) {
+                edgeMap[make_pair(srcNodeID, dstNodeID)] =
+                    agedge(G, nodeMap[srcNodeID], nodeMap[dstNodeID], nullptr, true);
+            });
+            forEachActiveNode(currentGroup, [&](NodeID nodeID) {
                 auto dimensions = ImNodes::GetNodeDimensions(nodeID);
                 agset(nodeMap[nodeID], STR("width"), STR(to_string(dimensions[0]/dpi).c_str()));
                 agset(nodeMap[nodeID], STR("height"), STR(to_string(dimensions[1]/dpi).c_str()));
-            }
+            });
 
             // Use GraphViz layout to layout the graph
             gvLayout(gvc, G, "dot");
-            for (NodeID nodeID : getActiveNodeIDs(currentGroup)) {
+            forEachActiveNode(currentGroup, [&](NodeID nodeID) {
                 Agnode_t *anode = nodeMap[nodeID];
                 auto pos = ND_coord(anode);
                 auto width = ND_width(anode) * dpi;
                 auto height = ND_height(anode) * dpi;
                 ImNodes::SetNodeGridSpacePos(nodeID, ImVec2(pos.x + width, - height - pos.y));
                 ImNodes::SetNodeDraggable(nodeID, true);
-            }
+            });
 
             // Cleanup layout
             gvFreeLayout(gvc, G);
@@ -193,24 +282,14 @@ namespace sail {
             gvFreeContext(gvc);
         }
 
-        for (auto edge : getActiveEdges(currentGroup)) {
-            AttributeID srcID = outputAttributeIDMap[edge.first];
-            AttributeID dstID = inputAttributeIDMap[edge.second];
-            pair<AttributeID, AttributeID> attrEdge = make_pair(srcID, dstID);
-            if (attrToLinkIDMap.find(attrEdge) == attrToLinkIDMap.end()) {
-                EdgeID newID = attrToLinkIDMap.size();
-                attrToLinkIDMap[attrEdge] = newID;
-                linkIDToNodeIDMap[newID] = make_pair(edge.first, edge.second);
-            }
-            ImNodes::Link(attrToLinkIDMap[attrEdge],
-                    outputAttributeIDMap[edge.first],
-                    inputAttributeIDMap[edge.second]);
-        }
+        forEachActiveEdge(currentGroup, [&](EdgeID linkID, NodeID srcNodeID, NodeID dstNodeID) {
+            ImNodes::Link(linkID, outputAttributeID(srcNodeID), inputAttributeID(dstNodeID));
+        });
 
         if (lastDisplayedEvent != currentEvent) {
             lastDisplayedEvent = currentEvent;
-            if (get<0>(currentEvent) == NODE_INFO) {
-                NodeID currentNodeID = get<3>(currentEvent);
+            if (currentEvent.type == NODE_INFO) {
+                NodeID currentNodeID = currentEvent.node1;
                 ImNodes::ClearNodeSelection();
                 ImNodes::ClearLinkSelection();
                 auto pos = ImNodes::GetNodeGridSpacePos(currentNodeID);
@@ -218,9 +297,9 @@ namespace sail {
                 auto editorSize = ImNodes::GetEditorDimensions();
                 ImNodes::EditorContextResetPanning(ImVec2((editorSize.x - nodeSize.x)/ 2.0 - pos.x, (editorSize.y - nodeSize.y)/ 2.0 - pos.y));
                 ImNodes::SelectNode(currentNodeID);
-            } else if (get<0>(currentEvent) == EDGE_INFO) {
-                NodeID currentNodeID1 = get<3>(currentEvent);
-                NodeID currentNodeID2 = get<4>(currentEvent);
+            } else if (currentEvent.type == EDGE_INFO) {
+                NodeID currentNodeID1 = currentEvent.node1;
+                NodeID currentNodeID2 = currentEvent.node2;
                 ImNodes::ClearNodeSelection();
                 ImNodes::ClearLinkSelection();
                 auto pos1 = ImNodes::GetNodeGridSpacePos(currentNodeID1);
@@ -228,116 +307,579 @@ namespace sail {
                 auto pos =  ImVec2((pos1.x + pos2.x) / 2.0, (pos1.y + pos2.y) / 2.0);
                 auto editorSize = ImNodes::GetEditorDimensions();
                 ImNodes::EditorContextResetPanning(ImVec2(editorSize.x / 2.0 - pos.x, editorSize.y / 2.0 - pos.y));
-                ImNodes::SelectLink(attrToLinkIDMap[make_pair(
-                                outputAttributeIDMap[currentNodeID1],
-                                inputAttributeIDMap[currentNodeID2])]);
+                EdgeID linkID = findLink(currentNodeID1, currentNodeID2);
+                if (linkID != NO_LINK)
+                    ImNodes::SelectLink(linkID);
             }
         }
         ImNodes::MiniMap(0.2f, ImNodesMiniMapLocation_TopRight);
         ImNodes::EndNodeEditor();
     }
 
-    void Timeline::addEvent(EVENT_TYPE type, string tag, string infoStr,
-            NodeID node1 = 0, NodeID node2 = 0) {
-        unsigned long long currentGlobalTimelineIndex = eventList.size();
-        unsigned long long infoStrIndex = eventInfoStrings.size();
-        eventInfoStrings.push_back(infoStr);
-        eventList.push_back(make_tuple(type, tag, infoStrIndex, node1, node2));
+    // The event columns and the tag index store event indices,
+    // NodeIDs and info string indices on 32 bits
+    static void checkEventLimits(unsigned long long eventCount, unsigned long long infoStrCount,
+            NodeID node1, NodeID node2) {
+        if (eventCount > ~0U || infoStrCount >= ~0U || node1 > ~0U || node2 > ~0U) {
+            cout << "Too many events or nodes in the trace\n";
+            exit(0);
+        }
+    }
 
-        auto eventTuple = make_tuple(type, node1, node2);
-        eventData[eventTuple].push_back(currentGlobalTimelineIndex);
+    void Timeline::appendEvent(EVENT_TYPE type, string_view tag, unsigned long long infoStrIndex,
+            NodeID node1, NodeID node2, LocationID location) {
+        unsigned long long currentGlobalTimelineIndex = size();
+        TagID tagID = internTag(tag);
+        eventTypes.push_back(type);
+        eventTags.push_back(tagID);
+        tagEvents[tagID].push_back(tagEventArena, currentGlobalTimelineIndex);
+        eventInfos.push_back(infoStrIndex == NO_INFO ? NO_INFO_ID : uint32_t(infoStrIndex));
+        eventNodes1.push_back(node1);
+        eventNodes2.push_back(node2);
+        locationEvents.add(location, currentGlobalTimelineIndex);
     }
 
-    void Timeline::addEvent(EVENT_TYPE type, string tag, unsigned long long prevInfoStrIndex,
+    void Timeline::addEvent(EVENT_TYPE type, string_view tag, string_view infoStr,
             NodeID node1 = 0, NodeID node2 = 0) {
-        unsigned long long currentGlobalTimelineIndex = eventList.size();
-        eventList.push_back(make_tuple(type, tag, prevInfoStrIndex, node1, node2));
+        newInfoLines.clear();
+        InfoStore::splitLines(infoStr, newInfoLines);
+        checkEventLimits(size() + 1, infos.size(), node1, node2);
+        appendEvent(type, tag, internInfo(newInfoLines.data(), newInfoLines.data() + newInfoLines.size()),
+                node1, node2, locationEvents.intern(EventLocation{ type, uint32_t(node1), uint32_t(node2) }));
+    }
+
+    void Timeline::addPrevInfoEvent(EVENT_TYPE type, string_view tag, NodeID node1, NodeID node2) {
+        checkEventLimits(size() + 1, infos.size(), node1, node2);
+        LocationID location = locationEvents.intern(EventLocation{ type, uint32_t(node1), uint32_t(node2) });
+        unsigned long long prevInfoStrIndex = NO_INFO;
+        if (locationEvents.getEventCount(location) > 0)
+            prevInfoStrIndex = getEventInfoIndex(locationEvents.getLastEvent(location));
+        appendEvent(type, tag, prevInfoStrIndex, node1, node2, location);
+    }
+
+    unsigned long long Timeline::internInfo(const InfoLine *begin, const InfoLine *end) {
+        unsigned long long infoStrIndex = infos.add(begin, end);
+        checkEventLimits(size(), infos.size(), 0, 0);
+        return infoStrIndex;
+    }
+
+    void Timeline::indexEventGroups(Graph &graph) {
+        uint32_t group = eventGroups.empty() ? NO_GROUP_ID : eventGroups.back();
+        eventGroups.reserve(size());
+        for (unsigned long long i = eventGroups.size(); i < size(); i++) {
+            if (getEventType(i) != GLOBAL_INFO)
+                group = graph.getNodeGroupID(getEventNode1(i));
+            if (!eventGroups.empty() && group != eventGroups.back())
+                groupSwitches.push_back(i);
+            eventGroups.push_back(group);
+        }
+    }
+
+    void Timeline::resize(unsigned long long eventCount) {
+        checkEventLimits(eventCount, infos.size(), 0, 0);
+        eventTypes.resize(eventCount);
+        eventTags.resize(eventCount);
+        eventInfos.resize(eventCount);
+        eventNodes1.resize(eventCount);
+        eventNodes2.resize(eventCount);
+    }
+
+    // Reports malformed instructions. Returns false if the instruction has to be skipped
+    static bool checkInstruction(const Instruction &instruction) {
+        switch (instruction.type) {
+            case INSTR_NODE:
+                if (instruction.argumentCount != 1) {
+                    cout << "Invalid number of arguments in >>node instruction: " << instruction.header << "\n";
+                    exit(0);
+                }
+                break;
+            case INSTR_EDGE:
+                if (instruction.argumentCount != 2) {
+                    cout << "Invalid number of arguments in >>edge instruction: " << instruction.header << "\n";
+                    exit(0);
+                }
+                if (instruction.body != "") {
+                    cout << ">>edge instruction does not take any data argument\n" << instruction.body << "\n";
+                    exit(0);
+                }
+                break;
+            case INSTR_UNKNOWN:
+                cout << "Unknown instruction " << instruction.keyword << " found in " << instruction.header << "\n";
+                return false;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    // Number of node name arguments used by the instruction
+    static size_t nodeArgumentCount(INSTRUCTION_TYPE type) {
+        switch (type) {
+            case INSTR_NODE: case INSTR_NODEINFO: case INSTR_PREVNODEINFO:
+                return 1;
+            case INSTR_EDGE: case INSTR_EDGEINFO: case INSTR_PREVEDGEINFO:
+                return 2;
+            default:
+                return 0;
+        }
+    }
 
-        auto eventTuple = make_tuple(type, node1, node2);
-        eventData[eventTuple].push_back(currentGlobalTimelineIndex);
+    static EVENT_TYPE eventType(INSTRUCTION_TYPE type) {
+        switch (type) {
+            case INSTR_NODEINFO: case INSTR_PREVNODEINFO:
+                return NODE_INFO;
+            case INSTR_EDGEINFO: case INSTR_PREVEDGEINFO:
+                return EDGE_INFO;
+            default:
+                return GLOBAL_INFO;
+        }
     }
 
-    void Trace::processInstruction(string currentInstruction) {
-        auto splitInstruction = splitOnFirst(currentInstruction, "\n");
-        string instructionHeader = splitInstruction.first;
-        string instructionBody = splitInstruction.second;
+    void Trace::processInstruction(const Instruction &instruction) {
+        if (!checkInstruction(instruction))
+            return;
 
-        auto headerTokens = splitOn(instructionHeader, " \t");
-        string instruction = headerTokens[0];
-        if (instruction == ">>node") {
-            if (headerTokens.size() != 2) {
-                cout << "Invalid number of arguments in >>node instruction: " << instructionHeader << "\n";
-                exit(0);
+        // Node names are resolved in argument order, so that NodeIDs are
+        // assigned in the order in which the names appear in the trace
+        NodeID node1 = 0, node2 = 0;
+        size_t nodeArguments = nodeArgumentCount(instruction.type);
+        if (nodeArguments > 0)
+            node1 = graph.getNodeID(instruction.arguments[0]);
+        if (nodeArguments > 1)
+            node2 = graph.getNodeID(instruction.arguments[1]);
+
+        switch (instruction.type) {
+            case INSTR_NODE:
+                graph.addNode(node1, instruction.body);
+                break;
+            case INSTR_EDGE:
+                graph.addEdge(node1, node2);
+                break;
+            case INSTR_NODEINFO: case INSTR_EDGEINFO: case INSTR_GLOBALINFO:
+                timeline.addEvent(eventType(instruction.type), instruction.tag, instruction.body, node1, node2);
+                break;
+            case INSTR_PREVNODEINFO: case INSTR_PREVEDGEINFO: case INSTR_PREVGLOBALINFO:
+                timeline.addPrevInfoEvent(eventType(instruction.type), instruction.tag, node1, node2);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Per chunk state of the parallel parser
+    struct ParseChunk {
+        string_view text;
+        vector<Instruction> instructions;
+        // Node names in the order of their first use in this chunk,
+        // and the chunk local index of the node arguments of every instruction
+        vector<string_view> nodeNames;
+        vector<pair<NodeID, NodeID>> localNodes;
+        // NodeID of every chunk local node
+        vector<NodeID> nodeIDs;
+        // Same for the tags of the events : the tags in the order of their first use,
+        // the chunk local index of the tag of every instruction, and their TagIDs
+        vector<string_view> tagNames;
+        vector<TagID> localTags;
+        vector<TagID> tagIDs;
+        // Event lists of the chunk below, stored in its own arena
+        Arena arena;
+        // Events of this chunk with every chunk local tag
+        vector<ArenaVector<uint32_t>> tagEvents;
+
+        // Position of the events of this chunk in the Timeline
+        unsigned long long firstEvent = 0, eventCount = 0;
+        // Events of this chunk, copied into the Timeline when the chunk is merged
+        struct ChunkEvent {
+            EVENT_TYPE type;
+            TagID tag;
+            NodeID node1, node2;
+        };
+        vector<ChunkEvent> events;
+        // Info bodies of the events of this chunk, split into lines and interned in chunk order.
+        // The lines of a body are infoLines[firstLine .. firstLine + lineCount)
+        struct InfoBody {
+            unsigned long long eventIndex;
+            size_t firstLine, lineCount;
+        };
+        vector<InfoBody> infoBodies;
+        vector<InfoLine> infoLines;
+        // Events of this chunk at every location
+        LocationIndex locationEvents;
+        // >>prev*info events along with the earlier event in this chunk whose info
+        // they reuse. NO_INFO if the info comes from an earlier chunk
+        vector<pair<unsigned long long, unsigned long long>> prevInfoEvents;
+    };
+
+    // Size of the chunks handed to the worker threads. Chunks are parsed in
+    // rounds of one chunk per thread, which bounds the memory used for
+    // tokenized instructions
+    const size_t PARSE_CHUNK_SIZE = 8 << 20;
+    // Under a memory budget, the chunks of a round are kept to a sixteenth of it :
+    // the tokenized instructions and info lines of a chunk take several times its size
+    const size_t MIN_PARSE_CHUNK_SIZE = 1 << 20;
+
+    // Parses the trace in rounds of chunks aligned on instruction boundaries :
+    //  1. (parallel) Tokenize the chunks and collect the node names they use
+    //  2. (serial)   Assign NodeIDs in chunk order, add nodes and edges
+    //  3. (parallel) Build the events of every chunk and split their info bodies into lines
+    //  4. (serial)   Append the events of every chunk, intern the info bodies,
+    //                resolve >>prev*info across chunks and merge the event data
+    // The trace is only locked during step 2 and while each chunk is appended,
+    // so that frames are rendered while the chunks are parsed.
+    // Names, events and info strings end up in exactly the same order as
+    // with the serial parser
+    void Trace::parseParallel(string_view contents, unsigned jobs) {
+        size_t chunkSize = PARSE_CHUNK_SIZE;
+        if (memoryBudget > 0)
+            chunkSize = max(MIN_PARSE_CHUNK_SIZE, min(chunkSize, memoryBudget / (16 * jobs)));
+        size_t roundSize = chunkSize * jobs;
+        for (size_t roundStart = 0; roundStart < contents.size() && !cancelLoading; ) {
+            // Extend the round to the next instruction boundary
+            size_t roundEnd = contents.size();
+            if (roundStart + roundSize < contents.size()) {
+                roundEnd = findInstructionBoundary(contents.data(), contents.size(), roundStart + roundSize - 1);
+                if (roundEnd < contents.size())
+                    roundEnd++;
             }
-            this->graph.addNode(headerTokens[1], instructionBody);
-        } else if (instruction == ">>edge") {
-            if (headerTokens.size() != 3) {
-                cout << "Invalid number of arguments in >>edge instruction: " << instructionHeader << "\n";
-                exit(0);
+            size_t roundBytes = roundEnd - roundStart;
+            vector<string_view> texts = splitIntoChunks(
+                    contents.substr(roundStart, roundBytes), jobs);
+            roundStart = roundEnd;
+            vector<ParseChunk> chunks(texts.size());
+
+            // 1. Tokenize
+            parallelFor(chunks.size(), jobs, [&](size_t c) {
+                ParseChunk &chunk = chunks[c];
+                chunk.text = texts[c];
+                NameTable localIDs;
+                auto localID = [&](string_view nodeName) {
+                    auto entry = localIDs.intern(nodeName);
+                    if (entry.second)
+                        chunk.nodeNames.push_back(nodeName);
+                    return NodeID(entry.first);
+                };
+                NameTable localTagIDs;
+                auto localTagID = [&](string_view tag) {
+                    auto entry = localTagIDs.intern(tag);
+                    if (entry.second)
+                        chunk.tagNames.push_back(tag);
+                    return TagID(entry.first);
+                };
+                for (size_t offset = 0; offset < chunk.text.size(); ) {
+                    chunk.instructions.push_back(parseInstruction(nextInstruction(chunk.text, offset)));
+                    Instruction &instruction = chunk.instructions.back();
+                    size_t nodeArguments = nodeArgumentCount(instruction.type);
+                    pair<NodeID, NodeID> nodes(0, 0);
+                    if (nodeArguments > 0)
+                        nodes.first = localID(instruction.arguments[0]);
+                    if (nodeArguments > 1)
+                        nodes.second = localID(instruction.arguments[1]);
+                    chunk.localNodes.push_back(nodes);
+                    bool isEvent = instruction.type != INSTR_NODE && instruction.type != INSTR_EDGE &&
+                        instruction.type != INSTR_UNKNOWN;
+                    chunk.localTags.push_back(isEvent ? localTagID(instruction.tag) : 0);
+                }
+            });
+
+            // 2. Assign NodeIDs and build the graph
+            unique_lock<mutex> lock(traceMutex);
+            unsigned long long eventCount = timeline.size();
+            for (ParseChunk &chunk : chunks) {
+                for (string_view nodeName : chunk.nodeNames)
+                    chunk.nodeIDs.push_back(graph.getNodeID(nodeName));
+                for (string_view tag : chunk.tagNames)
+                    chunk.tagIDs.push_back(timeline.internTag(tag));
+                chunk.firstEvent = eventCount;
+                for (size_t i = 0; i < chunk.instructions.size(); i++) {
+                    Instruction &instruction = chunk.instructions[i];
+                    if (!checkInstruction(instruction))
+                        continue;
+                    switch (instruction.type) {
+                        case INSTR_NODE:
+                            graph.addNode(chunk.nodeIDs[chunk.localNodes[i].first], instruction.body);
+                            break;
+                        case INSTR_EDGE:
+                            graph.addEdge(chunk.nodeIDs[chunk.localNodes[i].first],
+                                    chunk.nodeIDs[chunk.localNodes[i].second]);
+                            break;
+                        default:
+                            chunk.eventCount++;
+                            break;
+                    }
+                }
+                eventCount += chunk.eventCount;
             }
-            if (instructionBody != "") {
-                cout << ">>edge instruction does not take any data argument\n" << instructionBody << "\n";
-                exit(0);
+            lock.unlock();
+
+            // 3. Build the events. The loader thread is the only one that changes
+            // the trace, so the NodeIDs and TagIDs of the chunks stay valid
+            parallelFor(chunks.size(), jobs, [&](size_t c) {
+                ParseChunk &chunk = chunks[c];
+                unsigned long long eventIndex = chunk.firstEvent;
+                chunk.events.reserve(chunk.eventCount);
+                chunk.tagEvents.resize(chunk.tagNames.size());
+                for (size_t i = 0; i < chunk.instructions.size(); i++) {
+                    Instruction &instruction = chunk.instructions[i];
+                    if (instruction.type == INSTR_NODE || instruction.type == INSTR_EDGE ||
+                            instruction.type == INSTR_UNKNOWN)
+                        continue;
+                    EVENT_TYPE type = eventType(instruction.type);
+                    NodeID node1 = 0, node2 = 0;
+                    size_t nodeArguments = nodeArgumentCount(instruction.type);
+                    if (nodeArguments > 0)
+                        node1 = chunk.nodeIDs[chunk.localNodes[i].first];
+                    if (nodeArguments > 1)
+                        node2 = chunk.nodeIDs[chunk.localNodes[i].second];
+
+                    LocationID location = chunk.locationEvents.intern(
+                            EventLocation{ type, uint32_t(node1), uint32_t(node2) });
+                    if (instruction.type == INSTR_NODEINFO || instruction.type == INSTR_EDGEINFO ||
+                            instruction.type == INSTR_GLOBALINFO) {
+                        size_t firstLine = chunk.infoLines.size();
+                        InfoStore::splitLines(instruction.body, chunk.infoLines);
+                        chunk.infoBodies.push_back(ParseChunk::InfoBody{ eventIndex, firstLine,
+                                chunk.infoLines.size() - firstLine });
+                    } else
+                        chunk.prevInfoEvents.push_back(make_pair(eventIndex,
+                                    chunk.locationEvents.getEventCount(location) == 0 ? NO_INFO :
+                                    chunk.locationEvents.getLastEvent(location)));
+                    chunk.events.push_back(ParseChunk::ChunkEvent{ type, chunk.tagIDs[chunk.localTags[i]],
+                            node1, node2 });
+                    chunk.tagEvents[chunk.localTags[i]].push_back(chunk.arena, eventIndex);
+                    chunk.locationEvents.add(location, eventIndex++);
+                }
+            });
+
+            // 4. Append the events, intern the info bodies, resolve >>prev*info
+            // and merge the event data, in chunk order
+            for (ParseChunk &chunk : chunks) {
+                lock.lock();
+                timeline.resize(chunk.firstEvent + chunk.eventCount);
+                for (unsigned long long i = 0; i < chunk.eventCount; i++) {
+                    const ParseChunk::ChunkEvent &event = chunk.events[i];
+                    timeline.setEvent(chunk.firstEvent + i, event.type, event.tag, NO_INFO, event.node1, event.node2);
+                }
+                for (auto &info : chunk.infoBodies) {
+                    const InfoLine *lines = chunk.infoLines.data() + info.firstLine;
+                    timeline.setEventInfoIndex(info.eventIndex, timeline.internInfo(lines, lines + info.lineCount));
+                }
+                for (auto &prevInfoEvent : chunk.prevInfoEvents) {
+                    unsigned long long eventIndex = prevInfoEvent.first;
+                    unsigned long long infoStrIndex = NO_INFO;
+                    if (prevInfoEvent.second != NO_INFO)
+                        infoStrIndex = timeline.getEventInfoIndex(prevInfoEvent.second);
+                    else if (auto lastEvent = timeline.findLastEvent(timeline.getEventType(eventIndex),
+                                timeline.getEventNode1(eventIndex), timeline.getEventNode2(eventIndex)))
+                        infoStrIndex = timeline.getEventInfoIndex(*lastEvent);
+                    timeline.setEventInfoIndex(eventIndex, infoStrIndex);
+                }
+                timeline.appendLocationEvents(chunk.locationEvents);
+                for (size_t tag = 0; tag < chunk.tagEvents.size(); tag++)
+                    timeline.appendTagEvents(chunk.tagIDs[tag], chunk.tagEvents[tag].begin(), chunk.tagEvents[tag].end());
+                timeline.indexEventGroups(graph);
+                loadedBytes += chunk.text.size();
+                enforceMemoryBudget();
+                lock.unlock();
             }
-            this->graph.addEdge(headerTokens[1], headerTokens[2]);
-        } else if (instruction == ">>nodeinfo") {
-            string tag = splitOnFirst(splitOnFirst(instructionHeader, " \t").second, " \t").second;
-            timeline.addEvent(NODE_INFO, tag, instructionBody, graph.getNodeID(headerTokens[1]));
-        } else if (instruction == ">>edgeinfo") {
-            string tag = splitOnFirst(splitOnFirst(splitOnFirst(instructionHeader, " \t").second, " \t").second, " \t").second;
-            timeline.addEvent(EDGE_INFO, tag, instructionBody, graph.getNodeID(headerTokens[1]), graph.getNodeID(headerTokens[2]));
-        } else if (instruction == ">>globalinfo") {
-            string tag = splitOnFirst(instructionHeader, " \t").second;
-            timeline.addEvent(EVENT_TYPE::GLOBAL_INFO, tag, instructionBody);
-        } else if (instruction == ">>prevnodeinfo") {
-            string tag = splitOnFirst(splitOnFirst(instructionHeader, " \t").second, " \t").second;
-            NodeID node1 = graph.getNodeID(headerTokens[1]);
-            unsigned long long prevInfoStrIndex = get<2>(timeline.getEventAtIndex(
-                        timeline.getPrevEventIndex(timeline.size()-1, NODE_INFO, node1)));
-            timeline.addEvent(NODE_INFO, tag, prevInfoStrIndex, node1);
-        } else if (instruction == ">>prevedgeinfo") {
-            string tag = splitOnFirst(splitOnFirst(splitOnFirst(instructionHeader, " \t").second, " \t").second, " \t").second;
-            NodeID node1 = graph.getNodeID(headerTokens[1]), node2 = graph.getNodeID(headerTokens[2]);
-            unsigned long long prevInfoStrIndex = get<2>(timeline.getEventAtIndex(
-                        timeline.getPrevEventIndex(timeline.size()-1, EDGE_INFO, node1, node2)));
-            timeline.addEvent(EDGE_INFO, tag, prevInfoStrIndex, node1, node2);
-        } else if (instruction == ">>prevglobalinfo") {
-            string tag = splitOnFirst(instructionHeader, " \t").second;
-            unsigned long long prevInfoStrIndex = get<2>(timeline.getEventAtIndex(
-                        timeline.getPrevEventIndex(timeline.size()-1, GLOBAL_INFO)));
-            timeline.addEvent(GLOBAL_INFO, tag, prevInfoStrIndex);
-        } else {
-            cout << "Unknown instruction " << instruction << " found in " << instructionHeader << "\n";
         }
     }
 
-    Trace::Trace(string _filename) {
+    // Amount of text the serial parser tokenizes before it locks the
+    // trace to add the instructions, so that frames can be rendered in between
+    const size_t SERIAL_PARSE_BATCH_SIZE = 1 << 20;
+
+    void Trace::parseSerial(string_view contents) {
+        vector<Instruction> instructions;
+        for (size_t offset = 0; offset < contents.size() && !cancelLoading; ) {
+            size_t batchStart = offset;
+            size_t batchEnd = min(contents.size(), offset + SERIAL_PARSE_BATCH_SIZE);
+            instructions.clear();
+            while (offset < batchEnd)
+                instructions.push_back(parseInstruction(nextInstruction(contents, offset)));
+
+            lock_guard<mutex> lock(traceMutex);
+            for (const Instruction &instruction : instructions)
+                processInstruction(instruction);
+            timeline.indexEventGroups(graph);
+            loadedBytes += offset - batchStart;
+            enforceMemoryBudget();
+        }
+    }
+
+    // Traces smaller than this are not worth splitting across threads
+    const size_t PARALLEL_PARSE_THRESHOLD = 4 << 20;
+
+    void Trace::parseText(string_view contents) {
+        if (jobs > 1 && contents.size() >= PARALLEL_PARSE_THRESHOLD)
+            parseParallel(contents, jobs);
+        else
+            parseSerial(contents);
+    }
+
+    Trace::Trace(string _filename, unsigned jobs, bool useCache) {
         this->filename = _filename;
+        this->jobs = jobs == 0 ? defaultJobs() : jobs;
+        this->useCache = useCache;
+
+        // Map the file, the instructions are processed by load()
+        if (!traceFile.open(this->filename)) {
+            cout << "Unable to open tracefile " << this->filename << "\n";
+            exit(0);
+        }
+    }
+
+    Trace::Trace() {
+        this->jobs = 1;
+        this->useCache = false;
+    }
+
+    Trace::~Trace() {
+        cancelLoading = true;
+        streamQueue.close();
+        traceSocket.stop();
+        if (loader.joinable())
+            loader.join();
+    }
+
+    void Trace::load() {
+        loading = true;
+        loadStartTime = chrono::steady_clock::now();
+        loadContents();
+    }
+
+    void Trace::loadInBackground(bool follow) {
+        loading = true;
+        loadStartTime = chrono::steady_clock::now();
+        following = follow && !isBinaryTrace(traceFile.view()) &&
+            detectCompression(traceFile.view()) == COMPRESSION_NONE;
+        loader = thread([this]() {
+            loadContents();
+            if (following)
+                followContents(loadedBytes);
+        });
+    }
+
+    void Trace::loadContents() {
         cout << "Reading tracefile : " << this->filename << "\n";
-        
-        // Read the file and process the different instructions
-        ifstream inputstream(this->filename);
-        string line, currentInstruction;
-        while (getline (inputstream, line)) {
-            if (line.rfind(">>", 0) != 0) {
-                // This line is a part of the previous instruction
-                currentInstruction.append("\n");
-                currentInstruction.append(line);
-                continue;
+        string_view contents = traceFile.view();
+        // A trace that is still being written may end with a partial instruction,
+        // which is parsed by followContents() once it is complete
+        if (following)
+            contents = contents.substr(0, findLastInstruction(contents));
+
+        compression = detectCompression(contents);
+        if (!isCompressionSupported(compression)) {
+            cout << "Tracefile is compressed with " << getCompressionName(compression) <<
+                ", which is not supported by this build\n";
+            exit(0);
+        }
+
+        // Text traces are loaded from their index or from the cache
+        // if the trace did not change since they were written
+        TraceCacheKey cacheKey;
+        bool hasCacheKey = useCache && !following && !isBinaryTrace(contents) &&
+            getTraceCacheKey(this->filename, cacheKey);
+        bool cacheable = hasCacheKey && contents.size() >= TRACE_CACHE_THRESHOLD;
+
+        if (isBinaryTrace(contents)) {
+            lock_guard<mutex> lock(traceMutex);
+            loadBinary(contents);
+            loadedBytes = contents.size();
+        } else if (hasCacheKey && compression == COMPRESSION_NONE && loadIndex(cacheKey)) {
+            cout << "Loaded from index\n";
+            loadedBytes = contents.size();
+        } else {
+            uint64_t contentHash = cacheable ? hashTraceContents(contents, jobs) : 0;
+            if (cacheable && loadCache(cacheKey, contentHash)) {
+                cout << "Loaded from cache\n";
+                loadedBytes = contents.size();
+            } else {
+                if (compression != COMPRESSION_NONE)
+                    parseCompressed(contents);
+                else
+                    parseText(contents);
+                if (cacheable && !cancelLoading)
+                    writeCache(cacheKey, contentHash);
             }
-            // We have reached the next instruction, 
-            // so process the previous instruction
-            if (currentInstruction != "")   // Happens the first time
-                processInstruction(currentInstruction);
-            currentInstruction = line;
         }
-        processInstruction(currentInstruction);
+
+        if (!cancelLoading) {
+            lock_guard<mutex> lock(traceMutex);
+            graph.compact();
+            timeline.compactLocationEvents();
+            enforceMemoryBudget();
+            chrono::duration<double> loadTime = chrono::steady_clock::now() - loadStartTime;
+            printLoadStatistics(loadTime.count());
+        }
+        loading = false;
+    }
+
+    // Called with the trace locked after every batch of instructions. The info
+    // bodies get the part of the budget that the rest of the trace leaves
+    void Trace::enforceMemoryBudget() {
+        size_t used = graph.memoryUsage() + timeline.memoryUsage();
+        if (memoryBudget > 0) {
+            size_t otherBytes = used - timeline.infoBlockMemoryUsage();
+            timeline.setInfoBudget(memoryBudget > otherBytes ? memoryBudget - otherBytes : 0);
+            used = graph.memoryUsage() + timeline.memoryUsage();
+            // The text of the trace is read again from the files when it is accessed
+            traceFile.releasePages();
+            cacheFile.releasePages();
+            indexFile.releasePages();
+        }
+        memoryUsed = used;
+    }
+
+    void Trace::printLoadStatistics(double seconds) {
+        double megabytes = traceFile.size() / (1024.0 * 1024.0);
+        cout << "Loaded " << megabytes << " MB in " << seconds << " s";
+        if (seconds > 0)
+            cout << " (" << megabytes / seconds << " MB/s)";
+        if (compression != COMPRESSION_NONE)
+            cout << ", " << loadedBytes / (1024.0 * 1024.0) << " MB decompressed";
+        cout << " : " << graph.size() << " nodes, " << timeline.size() << " events, " <<
+            timeline.tagCount() << " tags\n";
+        if (timeline.infoBodySize() > 0)
+            cout << "Info bodies : " << timeline.infoBodySize() << ", " << timeline.infoStrSize() <<
+                " stored (deduplication ratio " << double(timeline.infoBodySize()) / timeline.infoStrSize() <<
+                "), " << timeline.infoLineSize() << " distinct lines, " <<
+                timeline.infoMemoryUsage() / (1024.0 * 1024.0) << " MB\n";
+        if (memoryBudget > 0) {
+            cout << "Memory : " << memoryUsed / (1024.0 * 1024.0) << " MB of the " <<
+                memoryBudget / (1024.0 * 1024.0) << " MB budget, " <<
+                timeline.infoSpilledSize() / (1024.0 * 1024.0) << " MB of info bodies spilled\n";
+            // Only the info blocks are spilled
+            size_t otherBytes = memoryUsed - timeline.infoBlockMemoryUsage();
+            if (otherBytes > memoryBudget)
+                cout << "The trace uses " << otherBytes / (1024.0 * 1024.0) << " MB besides the info blocks, " <<
+                    "which is more than the budget and stays in memory\n";
+        }
+#ifndef _WIN32
+        // Peak RSS : ru_maxrss is in kilobytes on Linux and in bytes on macOS
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+            double peakMegabytes = usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+            double peakMegabytes = usage.ru_maxrss / 1024.0;
+#endif
+            cout << "Peak resident memory : " << peakMegabytes << " MB\n";
+        }
+#endif
     }
 
     float lastTimelinePos = 0.0;
     float timelinePos = 0.0;
     char regexString[100];
+    // Regular expression of the Filtered Info view, and whether every info
+    // line matches it (-1 if the line was not tested yet)
+    string filterRegexString;
+    regex filterRegex("", regex_constants::basic | regex_constants::icase);
+    bool filterRegexValid = true;
+    vector<int8_t> filterLineMatches;
     void Trace::render() {
+        // The loader thread can not change the trace during the frame
+        lock_guard<mutex> lock(traceMutex);
         timelinePos = floor(timelinePos);
         if (timelinePos != lastTimelinePos) {
             timeline.setTimelineIndex(timelinePos);
@@ -350,12 +892,20 @@ namespace sail {
         if (ImGui::IsKeyPressed(ImGuiKey_H, true) ||
                 ImGui::IsKeyPressed(ImGuiKey_LeftArrow, true))
             timeline.moveToPrevEvent();
-        if (ImGui::IsKeyPressed(ImGuiKey_K, true) ||
-                ImGui::IsKeyPressed(ImGuiKey_UpArrow, true))
+        if ((ImGui::IsKeyPressed(ImGuiKey_K, true) ||
+                ImGui::IsKeyPressed(ImGuiKey_UpArrow, true)) && timeline.size() > 0)
             timeline.moveToCurrentNextEvent();
-        if (ImGui::IsKeyPressed(ImGuiKey_J, true) ||
-                ImGui::IsKeyPressed(ImGuiKey_DownArrow, true))
+        if ((ImGui::IsKeyPressed(ImGuiKey_J, true) ||
+                ImGui::IsKeyPressed(ImGuiKey_DownArrow, true)) && timeline.size() > 0)
             timeline.moveToCurrentPrevEvent();
+        if (ImGui::IsKeyPressed(ImGuiKey_N, true) && timeline.size() > 0)
+            timeline.moveToCurrentNextTagEvent();
+        if (ImGui::IsKeyPressed(ImGuiKey_P, true) && timeline.size() > 0)
+            timeline.moveToCurrentPrevTagEvent();
+        if (ImGui::IsKeyPressed(ImGuiKey_RightBracket, true))
+            timeline.moveToNextGroupSwitch();
+        if (ImGui::IsKeyPressed(ImGuiKey_LeftBracket, true))
+            timeline.moveToPrevGroupSwitch();
 
         timelinePos = timeline.getTimelineIndex();
 
@@ -374,12 +924,43 @@ namespace sail {
 
         // 1. Graph View
         ImGui::SetNextWindowSize(graphViewSize);
-        graph.renderGraphView(timeline.getCurrentGroup(graph), timeline.getCurrentEvent());
+        // No event has been loaded yet
+        Event noEvent = { GLOBAL_INFO, string_view(), NO_INFO, 0, 0 };
+        graph.renderGraphView(timeline.getCurrentGroup(graph),
+                timeline.size() == 0 ? noEvent : timeline.getCurrentEvent());
 
         // 2. Side Pane
         ImGui::SameLine();
-        if (timeline.size() == 0) return;
         ImGui::BeginChild("Side Pane", sidePaneSize, true, ImGuiChildFlags_FrameStyle);
+        if (loading) {
+            // Progress of the background load
+            chrono::duration<double> loadTime = chrono::steady_clock::now() - loadStartTime;
+            // Compressed traces are read ahead of the parser by the decompression thread
+            size_t readBytes = compression == COMPRESSION_NONE ? size_t(loadedBytes) : size_t(decompressedBytes);
+            double megabytes = readBytes / (1024.0 * 1024.0);
+            double eventsPerSecond = loadTime.count() > 0 ? timeline.size() / loadTime.count() : 0.0;
+            char progress[100];
+            snprintf(progress, sizeof(progress), "Loading : %.1f / %.1f MB, %.0f events/s",
+                    megabytes, traceFile.size() / (1024.0 * 1024.0), eventsPerSecond);
+            ImGui::ProgressBar(traceFile.size() == 0 ? 1.0f : float(readBytes) / traceFile.size(),
+                    ImVec2(-1.0f, 0.0f), progress);
+        } else if (following && listening) {
+            ImGui::Text("Receiving : %.1f MB, %llu events, %.1f MB queued", loadedBytes / (1024.0 * 1024.0),
+                    timeline.size(), streamQueue.size() / (1024.0 * 1024.0));
+        } else if (following) {
+            ImGui::Text("Following : %.1f MB, %llu events", loadedBytes / (1024.0 * 1024.0), timeline.size());
+        }
+        if (memoryBudget > 0) {
+            char usage[100];
+            snprintf(usage, sizeof(usage), "Memory : %.1f / %.1f MB, %.1f MB spilled", memoryUsed / (1024.0 * 1024.0),
+                    memoryBudget / (1024.0 * 1024.0), timeline.infoSpilledSize() / (1024.0 * 1024.0));
+            ImGui::ProgressBar(min(1.0f, float(memoryUsed) / memoryBudget), ImVec2(-1.0f, 0.0f), usage);
+        }
+        if (timeline.size() == 0) {
+            ImGui::EndChild();
+            ImGui::End();
+            return;
+        }
         if (ImGui::ArrowButton("Left", ImGuiDir_Left))
             timeline.moveToPrevEvent();
         ImGui::SameLine();
@@ -388,60 +969,98 @@ namespace sail {
         ImGui::SameLine();
         ImGui::SliderFloat("Timeline", &timelinePos, 0.0, timeline.size(), "", 0);
 
-        Event &currentEvent = timeline.getCurrentEvent();
-        string currentEventTag = get<1>(currentEvent);
-        string currentEventInfo = timeline.getStringAtIndex(get<2>(currentEvent));
+        Event currentEvent = timeline.getCurrentEvent();
+        string_view currentEventTag = currentEvent.tag;
+        unsigned long long currentEventInfo = currentEvent.infoStrIndex;
 
         // If any node or edge is being hovered, display the Prev Info at that node/edge
         int hoveredID;
         auto currentTimelineIndex = timeline.getTimelineIndex();
         if (ImNodes::IsNodeHovered(&hoveredID)) {
-            unsigned long long prevNodeIndex = timeline.getPrevEventIndex(
-                    currentTimelineIndex, NODE_INFO, hoveredID);
-            if (prevNodeIndex > currentTimelineIndex) {
+            auto prevNodeIndex = timeline.findPrevEvent(currentTimelineIndex, NODE_INFO, hoveredID);
+            if (!prevNodeIndex) {
                 currentEventTag = "";
-                currentEventInfo = "";
+                currentEventInfo = NO_INFO;
             } else {
-                Event &prevNodeEvent = timeline.getEventAtIndex(prevNodeIndex);
-                currentEventTag = get<1>(prevNodeEvent);
-                currentEventInfo = timeline.getStringAtIndex(get<2>(prevNodeEvent));
+                currentEventTag = timeline.getEventTag(*prevNodeIndex);
+                currentEventInfo = timeline.getEventInfoIndex(*prevNodeIndex);
             }
         }
         if (ImNodes::IsLinkHovered(&hoveredID)) {
             NodeID node1, node2;
             std::tie (node1, node2) = graph.getLink(hoveredID);
-            unsigned long long prevNodeIndex = timeline.getPrevEventIndex(
-                    currentTimelineIndex, EDGE_INFO, node1, node2);
-            if (prevNodeIndex > currentTimelineIndex) {
+            auto prevEdgeIndex = timeline.findPrevEvent(currentTimelineIndex, EDGE_INFO, node1, node2);
+            if (!prevEdgeIndex) {
                 currentEventTag = "";
-                currentEventInfo = "";
+                currentEventInfo = NO_INFO;
             } else {
-                Event &prevNodeEvent = timeline.getEventAtIndex(prevNodeIndex);
-                currentEventTag = get<1>(prevNodeEvent);
-                currentEventInfo = timeline.getStringAtIndex(get<2>(prevNodeEvent));
+                currentEventTag = timeline.getEventTag(*prevEdgeIndex);
+                currentEventInfo = timeline.getEventInfoIndex(*prevEdgeIndex);
             }
         }
 
         if (ImGui::TreeNodeEx("Info view", ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_SpanFullWidth)) {
-            ImGui::Text(currentEventTag.c_str());
-            ImGui::Text(currentEventInfo.c_str());
+            ImGui::TextUnformatted(currentEventTag.data(), currentEventTag.data() + currentEventTag.size());
+            string infoText = timeline.getInfoString(currentEventInfo);
+            ImGui::TextUnformatted(infoText.data(), infoText.data() + infoText.size());
             ImGui::TreePop();
         }
         if (ImGui::TreeNodeEx("Filtered Info view", ImGuiTreeNodeFlags_SpanFullWidth)) {
             ImGui::InputText("Regular Expression", regexString, 99);
-            try {
-                regex regex(regexString, regex_constants::basic | regex_constants::icase);
+            if (filterRegexString != regexString) {
+                filterRegexString = regexString;
+                filterLineMatches.clear();
+                try {
+                    filterRegex = regex(regexString, regex_constants::basic | regex_constants::icase);
+                    filterRegexValid = true;
+                } catch (const regex_error &) {
+                    filterRegexValid = false;
+                }
+            }
+            if (filterRegexValid) {
+                // Every distinct line is matched once per regular expression.
+                // The lines of an index are interned as they are read, hence the resize afterwards
                 string stringToDisplay;
-                smatch match;
-                for (string line : splitOn(currentEventInfo, "\n"))
-                    if (regex_search(line, match, regex))
-                        stringToDisplay.append(line + "\n");
-                ImGui::Text(stringToDisplay.c_str());
-            } catch (regex_error e) {
+                size_t lineCount;
+                const LineID *lines = timeline.getInfoLines(currentEventInfo, lineCount);
+                filterLineMatches.resize(timeline.infoLineSize(), -1);
+                for (size_t i = 0; i < lineCount; i++) {
+                    string_view line = timeline.getInfoLine(lines[i]);
+                    int8_t &matches = filterLineMatches[lines[i]];
+                    if (matches < 0) {
+                        cmatch match;
+                        matches = regex_search(line.data(), line.data() + line.size(), match, filterRegex);
+                    }
+                    if (matches)
+                        stringToDisplay.append(line).append("\n");
+                }
+                ImGui::TextUnformatted(stringToDisplay.c_str());
+            } else {
                 ImGui::Text("Incorrect regular expression");
             }
             ImGui::TreePop();
         }
+        if (ImGui::TreeNodeEx("Tags", ImGuiTreeNodeFlags_SpanFullWidth)) {
+            // Every tag with its number of events. Selecting a tag moves to
+            // its next event, or back to its first event after the last one
+            TagID currentTag = timeline.getEventTagID(currentTimelineIndex);
+            ImGuiListClipper clipper;
+            clipper.Begin(timeline.tagCount());
+            while (clipper.Step()) {
+                for (int tag = clipper.DisplayStart; tag < clipper.DisplayEnd; tag++) {
+                    string_view tagName = timeline.getTag(tag);
+                    string label = string(tagName.empty() ? "(no tag)" : tagName) + " : " +
+                        to_string(timeline.getTagEventCount(tag)) + "##" + to_string(tag);
+                    if (ImGui::Selectable(label.c_str(), TagID(tag) == currentTag)) {
+                        unsigned long long nextIndex = timeline.getNextTagEventIndex(currentTimelineIndex, tag);
+                        if (nextIndex == currentTimelineIndex)
+                            nextIndex = timeline.getFirstTagEventIndex(tag);
+                        timeline.setTimelineIndex(nextIndex);
+                    }
+                }
+            }
+            ImGui::TreePop();
+        }
         ImGui::EndChild();
         ImGui::End();
     }
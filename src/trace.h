@@ -1,11 +1,30 @@
 /*
  * Trace class contians the trace file parsing, traversal and rendering
  */
+#include <algorithm>
 #include <map>
-#include <set>
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <SDL.h>
+#include "mappedfile.h"
+#include "arena.h"
+#include "nametable.h"
+#include "infostore.h"
+#include "locationindex.h"
+#include "parser.h"
+#include "binarytrace.h"
+#include "tracecache.h"
+#include "traceindex.h"
+#include "tracesocket.h"
+#include "compression.h"
 
 using namespace std;
 
@@ -14,70 +33,333 @@ namespace sail {
     typedef unsigned long long NodeID;
     typedef unsigned long long EdgeID;
     typedef unsigned long long AttributeID;
+    typedef unsigned long long GroupID;
+    typedef unsigned long long TagID;
+    // Group of the nodes displayed when there is no node to display
+    const GroupID NO_GROUP = ~0ULL;
 
     enum EVENT_TYPE { NODE_INFO, EDGE_INFO, GLOBAL_INFO };
-    typedef tuple<EVENT_TYPE, string, unsigned long long, NodeID, NodeID> Event;
+    // Info string index of events that have no info (>>prev*info without a previous event)
+    const unsigned long long NO_INFO = ~0ULL;
+
+    // An event of the timeline. The Timeline stores every field of the
+    // events in its own column, and returns copies of them as Event
+    struct Event {
+        EVENT_TYPE type = GLOBAL_INFO;
+        string_view tag;
+        unsigned long long infoStrIndex = NO_INFO;
+        NodeID node1 = 0, node2 = 0;
+
+        bool operator==(const Event &other) const {
+            return type == other.type && tag == other.tag && infoStrIndex == other.infoStrIndex &&
+                node1 == other.node1 && node2 == other.node2;
+        }
+        bool operator!=(const Event &other) const   { return !(*this == other); }
+    };
 
     class Graph {
         private:
-            // Maps groupName -> Map of node names in that group to the corresponding NodeID
-            map<string,map<string,NodeID>> nodeIDs;
-            // Vector of node names. The NodeID will be the index into this vector
-            vector<string> nodeNames;
-            // Node contents
-            map<NodeID,string> nodeContents;
-
-            // Edges of the graph in adjancency list format
-            // Map from source Node ID to vector of destination Node ID
-            map<NodeID, set<NodeID>> edges;
-
-            // Map from nodeID to input/output attribute ID
-            map<NodeID, AttributeID> inputAttributeIDMap;
-            map<NodeID, AttributeID> outputAttributeIDMap;
-            map<pair<AttributeID, AttributeID>, EdgeID> attrToLinkIDMap;
-            map<EdgeID, pair<NodeID, NodeID>> linkIDToNodeIDMap;
+            // Interned node names. The NodeID is the ID of the name in the table
+            // Names and contents are views into the trace file, or copies in
+            // streamedText for the text that is released once parsed
+            NameTable nodeNames;
+            // Interned group names ("" for nodes without a group). The GroupID
+            // is the ID of the name in the table
+            NameTable groupNames;
+            // Group of every node
+            vector<GroupID> nodeGroups;
+            // Node contents, and their total size
+            map<NodeID,string_view> nodeContents;
+            size_t contentBytes = 0;
+            bool copyStrings = false;
+            Arena streamedText;
+
+            // The nodes ordered by group, in NodeID order within a group : the nodes of
+            // group g are groupNodes[groupOffsets[g] .. groupOffsets[g + 1]).
+            // nodePositions is the position of every node in groupNodes
+            vector<uint64_t> groupOffsets;
+            vector<NodeID> groupNodes;
+            vector<uint64_t> nodePositions;
+            // Edges in compressed sparse rows, in the order of groupNodes : the successors
+            // of the node at position p are edgeTargets[edgeOffsets[p] .. edgeOffsets[p + 1]),
+            // sorted, so that the edges from a group are contiguous as well.
+            // edgeSources holds the source of every edge of the rows.
+            // The predecessors of the node are stored the same way
+            vector<uint64_t> edgeOffsets;
+            vector<NodeID> edgeTargets;
+            vector<NodeID> edgeSources;
+            vector<uint64_t> predecessorOffsets;
+            vector<NodeID> predecessorSources;
+            // Nodes and edges added since the last compaction.
+            // An edge may be pending more than once, compact() removes the repeats
+            vector<NodeID> pendingNodes;
+            vector<pair<NodeID, NodeID>> pendingEdges;
+
+            // Attributes of the nodes and links of the edges in the node editor.
+            // The link of an edge of the rows is its position in edgeTargets, the
+            // pending edges come after them (their links change with compact())
+            static AttributeID inputAttributeID(NodeID nodeID)  { return 2 * nodeID; }
+            static AttributeID outputAttributeID(NodeID nodeID) { return 2 * nodeID + 1; }
 
             // Last displayed group : Used to figure out when to call GraphViz for layout
-            string lastDisplayedGroup = "-------";
+            GroupID lastDisplayedGroup = NO_GROUP;
             Event lastDisplayedEvent;
+            // Size of the displayed group at its last layout, and when it was done
+            size_t lastLayoutNodeCount = 0;
+            size_t lastLayoutEdgeCount = 0;
+            chrono::steady_clock::time_point lastLayoutTime;
+
+            void compactIfNeeded();
 
         public:
-            void addNode(string nodeName, std::string nodeContents); 
-            void addEdge(string srcNodeName, string dstNodeName); 
-            NodeID getNodeID(string nodeName);
-            std::string getNodeName(NodeID nodeID);
-            std::string getNodeGroupName(NodeID nodeID);
-            std::string getNodeContents(NodeID nodeID);
-            pair<NodeID, NodeID> getLink(EdgeID linkID);
+            void addNode(string_view nodeName, string_view nodeContents); 
+            void addNode(NodeID nodeID, string_view nodeContents);
+            void addEdge(string_view srcNodeName, string_view dstNodeName); 
+            void addEdge(NodeID srcNodeID, NodeID dstNodeID);
+            NodeID getNodeID(string_view nodeName);
+            string_view getNodeName(NodeID nodeID);
+            GroupID getNodeGroupID(NodeID nodeID)   { return nodeGroups[nodeID]; }
+            // Returns NO_GROUP if there is no node in the group
+            GroupID getGroupID(string_view groupName);
+            string_view getGroupName(GroupID groupID)   { return groupNames.getName(groupID); }
+            string_view getNodeContents(NodeID nodeID);
+            // Copies the names and contents added afterwards, for text that is released once parsed
+            void setCopyStrings(bool copy)  { copyStrings = copy; }
+            // Returns the source and destination of the link
+            pair<NodeID, NodeID> getLink(EdgeID linkID) {
+                if (linkID < edgeTargets.size())
+                    return make_pair(edgeSources[linkID], edgeTargets[linkID]);
+                return pendingEdges[linkID - edgeTargets.size()];
+            }
+            // Returns the link of the edge, or NO_LINK if there is no such edge
+            EdgeID findLink(NodeID srcNodeID, NodeID dstNodeID);
+            static const EdgeID NO_LINK = ~0ULL;
+            unsigned long long size()   { return nodeNames.size(); }
+            // Bytes used by the tables built while loading, and the copied strings.
+            // The node contents are counted by contentSize() as well
+            size_t memoryUsage();
+            size_t contentSize()        { return contentBytes; }
+
+            // Rebuilds the rows with the pending nodes and edges. Done when they
+            // are as many as the compacted ones, and at the end of the load
+            void compact();
 
-            vector<NodeID> getActiveNodeIDs(string currentGroup);
-            vector<pair<NodeID, NodeID>> getActiveEdges(string currentGroup);
+            // Calls visit(nodeID) for the nodes of the group, then for its pending nodes
+            template <typename Visit> void forEachActiveNode(GroupID group, Visit visit) {
+                if (group == NO_GROUP)
+                    return;
+                if (group + 1 < groupOffsets.size())
+                    for (uint64_t position = groupOffsets[group]; position < groupOffsets[group + 1]; position++)
+                        visit(groupNodes[position]);
+                for (NodeID nodeID : pendingNodes)
+                    if (nodeGroups[nodeID] == group)
+                        visit(nodeID);
+            }
+            // Calls visit(linkID, srcNodeID, dstNodeID) for the edges from the nodes of the group
+            template <typename Visit> void forEachActiveEdge(GroupID group, Visit visit) {
+                if (group == NO_GROUP)
+                    return;
+                if (group + 1 < groupOffsets.size())
+                    for (uint64_t edge = edgeOffsets[groupOffsets[group]]; edge < edgeOffsets[groupOffsets[group + 1]]; edge++)
+                        visit(EdgeID(edge), edgeSources[edge], edgeTargets[edge]);
+                for (size_t edge = 0; edge < pendingEdges.size(); edge++)
+                    if (nodeGroups[pendingEdges[edge].first] == group)
+                        visit(EdgeID(edgeTargets.size() + edge), pendingEdges[edge].first, pendingEdges[edge].second);
+            }
+            size_t getActiveNodeCount(GroupID group);
+            size_t getActiveEdgeCount(GroupID group);
+            // Calls visit(nodeID) for the successors / predecessors of the node
+            template <typename Visit> void forEachSuccessor(NodeID nodeID, Visit visit) {
+                if (nodeID < nodePositions.size())
+                    for (uint64_t edge = edgeOffsets[nodePositions[nodeID]]; edge < edgeOffsets[nodePositions[nodeID] + 1]; edge++)
+                        visit(edgeTargets[edge]);
+                for (auto &edge : pendingEdges)
+                    if (edge.first == nodeID)
+                        visit(edge.second);
+            }
+            template <typename Visit> void forEachPredecessor(NodeID nodeID, Visit visit) {
+                if (nodeID < nodePositions.size())
+                    for (uint64_t edge = predecessorOffsets[nodePositions[nodeID]];
+                            edge < predecessorOffsets[nodePositions[nodeID] + 1]; edge++)
+                        visit(predecessorSources[edge]);
+                for (auto &edge : pendingEdges)
+                    if (edge.second == nodeID)
+                        visit(edge.first);
+            }
 
             // Render the active nodes in the NodeEditor
-            void renderGraphView(string currentGroup, Event currentEvent);
+            void renderGraphView(GroupID currentGroup, Event currentEvent);
+
+            // Conversion to and from the binary trace format (binarytrace.cpp)
+            void writeBinary(BinaryTraceWriter &writer);
+            void loadBinary(const BinaryTraceReader &reader);
     };
 
     class Timeline {
         private:
-            // Vector of info strings
-            vector<string> eventInfoStrings;
-            // Event : Type, Tag, InfoStrIndex, NodeID1, NodeID2
-            vector<tuple<EVENT_TYPE, string, unsigned long long, NodeID, NodeID>> eventList;
-            // Map from the Event tuple to a sorted vector indices in the eventList
+            // Info strings, stored as interned lines. Identical info bodies
+            // are interned as well, so that events share a single info string
+            InfoStore infos;
+            // Events, one column per field, indexed by the position of the event
+            // in the timeline : Type, TagID, InfoStrIndex, NodeID1, NodeID2
+            // Events without info are stored with NO_INFO_ID
+            vector<uint8_t> eventTypes;
+            vector<uint32_t> eventTags;
+            vector<uint32_t> eventInfos;
+            vector<uint32_t> eventNodes1;
+            vector<uint32_t> eventNodes2;
+            static const uint32_t NO_INFO_ID = ~0U;
+            // Interned tags. The TagID is the ID of the tag in the table.
+            // Tags of text that is released once parsed are copied to tagText
+            NameTable tags;
+            bool copyTags = false;
+            Arena tagText;
+            // Sorted indices of the events of every tag, stored in tagEventArena
+            vector<ArenaVector<uint32_t>> tagEvents;
+            Arena tagEventArena;
+            // Sorted indices of the events of every node, edge and of the global location
             // Used for moving between events of the same node / edge, and for hovering
-            map<tuple<enum EVENT_TYPE, NodeID, NodeID>, vector<unsigned long long>> eventData;
+            LocationIndex locationEvents;
+            // Group displayed at every event : the group of the last node or edge event up
+            // to it, NO_GROUP_ID before the first one. groupSwitches holds the events whose
+            // group differs from the group of the event before them
+            vector<uint32_t> eventGroups;
+            vector<uint32_t> groupSwitches;
+            static const uint32_t NO_GROUP_ID = ~0U;
 
             unsigned long long currentTimelineIndex = 0;
+            // Lines of the info body being added
+            vector<InfoLine> newInfoLines;
+
+            void appendEvent(EVENT_TYPE type, string_view tag, unsigned long long infoStrIndex,
+                    NodeID node1, NodeID node2, LocationID location);
 
         public:
-            void addEvent(EVENT_TYPE type, string tag, string info, NodeID node1, NodeID node2);
-            void addEvent(EVENT_TYPE type, string tag, unsigned long long prevInfoStrIndex, NodeID node1, NodeID node2);
-            unsigned long long size()   { return eventList.size(); }
-            Event& getCurrentEvent()    { return eventList[currentTimelineIndex]; }
-            Event& getEventAtIndex(unsigned long long index)    { return eventList[index]; }
-            string& getStringAtIndex(unsigned long long index)    { return eventInfoStrings[index]; }
+            void addEvent(EVENT_TYPE type, string_view tag, string_view info, NodeID node1, NodeID node2);
+            // Adds an event that reuses the info of the last event at the same location
+            // (>>prev*info), or has no info if there is none. The location is looked up once
+            void addPrevInfoEvent(EVENT_TYPE type, string_view tag, NodeID node1, NodeID node2);
+            unsigned long long size() const { return eventTypes.size(); }
+
+            // Conversion to and from the binary trace format (binarytrace.cpp).
+            // infoTexts, if any, holds the text of every info string in the text
+            // trace, which is written instead of its lines (sidecar index)
+            void writeBinary(BinaryTraceWriter &writer, const vector<string_view> &infoTexts = vector<string_view>());
+            void loadBinary(const BinaryTraceReader &reader, unsigned long long nodeCount);
+            unsigned long long infoStrSize()    { return infos.size(); }
+            // Number of info bodies in the trace, before they were interned
+            unsigned long long infoBodySize()   { return infos.addedCount(); }
+            unsigned long long infoLineSize()   { return infos.lineCount(); }
+            size_t infoMemoryUsage()            { return infos.memoryUsage(); }
+            // Bytes of compressed info blocks to keep in memory, see InfoStore::setBudget()
+            void setInfoBudget(size_t bytes)    { infos.setBudget(bytes); }
+            size_t infoBlockMemoryUsage()       { return infos.blockMemoryUsage(); }
+            size_t infoSpilledSize()            { return infos.spilledSize(); }
+            // Bytes used by the event columns
+            size_t eventMemoryUsage() {
+                return eventTypes.capacity() * sizeof(uint8_t) + (eventTags.capacity() + eventInfos.capacity() +
+                        eventNodes1.capacity() + eventNodes2.capacity() + eventGroups.capacity() +
+                        groupSwitches.capacity()) * sizeof(uint32_t);
+            }
+
+            // Accessors of the events
+            EVENT_TYPE getEventType(unsigned long long index) const { return EVENT_TYPE(eventTypes[index]); }
+            TagID getEventTagID(unsigned long long index) const     { return eventTags[index]; }
+            string_view getEventTag(unsigned long long index) const { return tags.getName(eventTags[index]); }
+            unsigned long long getEventInfoIndex(unsigned long long index) const {
+                return eventInfos[index] == NO_INFO_ID ? NO_INFO : eventInfos[index];
+            }
+            NodeID getEventNode1(unsigned long long index) const    { return eventNodes1[index]; }
+            NodeID getEventNode2(unsigned long long index) const    { return eventNodes2[index]; }
+            Event getEvent(unsigned long long index) {
+                return Event{ getEventType(index), getEventTag(index), getEventInfoIndex(index),
+                    getEventNode1(index), getEventNode2(index) };
+            }
+            Event getCurrentEvent()     { return getEvent(currentTimelineIndex); }
+
+            // Tag dictionary
+            unsigned long long tagCount()                       { return tags.size(); }
+            string_view getTag(TagID tag)                       { return tags.getName(tag); }
+            unsigned long long getTagEventCount(TagID tag)      { return tagEvents[tag].size(); }
+            // Returns the next / previous event with the tag,
+            // or currentIndex if there is none
+            unsigned long long getNextTagEventIndex(unsigned long long currentIndex, TagID tag) {
+                auto &events = tagEvents[tag];
+                auto next = upper_bound(events.begin(), events.end(), currentIndex);
+                return next == events.end() ? currentIndex : *next;
+            }
+            unsigned long long getPrevTagEventIndex(unsigned long long currentIndex, TagID tag) {
+                auto &events = tagEvents[tag];
+                auto next = lower_bound(events.begin(), events.end(), currentIndex);
+                return next == events.begin() ? currentIndex : *(next - 1);
+            }
+            unsigned long long getFirstTagEventIndex(TagID tag) {
+                return tagEvents[tag].empty() ? currentTimelineIndex : tagEvents[tag][0];
+            }
+            // Text of the info string, empty for NO_INFO
+            string getInfoString(unsigned long long index) {
+                if (index >= infos.size()) return string();
+                return infos.getBody(index);
+            }
+            // Lines of the info string, none for NO_INFO. See InfoStore::getLines()
+            const LineID *getInfoLines(unsigned long long index, size_t &lineCount) {
+                lineCount = 0;
+                return index >= infos.size() ? nullptr : infos.getLines(index, lineCount);
+            }
+            string_view getInfoLine(LineID line)                    { return infos.getLine(line); }
+
+            // Bulk construction used by the parallel parser :
+            // The events of every chunk are allocated and then filled in.
+            // Tags are interned beforehand, as the events are built on several threads.
+            // Info bodies are split into lines on the threads and interned afterwards
+            void resize(unsigned long long eventCount);
+            unsigned long long internInfo(const InfoLine *begin, const InfoLine *end);
+            TagID internTag(string_view tag) {
+                auto entry = tags.intern(tag);
+                if (entry.second) {
+                    if (copyTags)
+                        tags.setName(entry.first, tagText.copy(tag));
+                    tagEvents.emplace_back();
+                }
+                return entry.first;
+            }
+            // Copies the tags added afterwards, for text that is released once parsed
+            void setCopyStrings(bool copy)  { copyTags = copy; }
+            // Appends the sorted indices of events that have the tag
+            void appendTagEvents(TagID tag, const uint32_t *begin, const uint32_t *end) {
+                tagEvents[tag].append(tagEventArena, begin, end);
+            }
+            void setEvent(unsigned long long index, EVENT_TYPE type, TagID tag,
+                    unsigned long long infoStrIndex, NodeID node1, NodeID node2) {
+                eventTypes[index] = type;
+                eventTags[index] = tag;
+                eventNodes1[index] = node1;
+                eventNodes2[index] = node2;
+                setEventInfoIndex(index, infoStrIndex);
+            }
+            void setEventInfoIndex(unsigned long long index, unsigned long long infoStrIndex) {
+                eventInfos[index] = infoStrIndex == NO_INFO ? NO_INFO_ID : uint32_t(infoStrIndex);
+            }
+            // Appends the events of a chunk, which come after the events of the timeline
+            void appendLocationEvents(const LocationIndex &chunkEvents)   { locationEvents.merge(chunkEvents); }
+            // Merges the location events added during the load into their rows
+            void compactLocationEvents()                { locationEvents.compact(); }
+            // Computes the group of the events added since the last call.
+            // Called after every batch, once the NodeIDs of the events are set
+            void indexEventGroups(Graph &graph);
+            unsigned long long locationCount()          { return locationEvents.size(); }
+            size_t locationMemoryUsage()                { return locationEvents.memoryUsage(); }
+            // Bytes used by the events, the tags, the location index and the info bodies
+            size_t memoryUsage() {
+                return eventMemoryUsage() + tags.memoryUsage() + tagText.memoryUsage() +
+                    tagEvents.capacity() * sizeof(ArenaVector<uint32_t>) +
+                    tagEventArena.memoryUsage() + locationMemoryUsage() + infoMemoryUsage();
+            }
 
             void setTimelineIndex(unsigned long long index) {
+                // The timeline may still be growing while the trace is loaded
+                if (index >= size())
+                    index = size() == 0 ? 0 : size() - 1;
                 currentTimelineIndex = index;
             }
             unsigned long long getTimelineIndex() {
@@ -85,7 +367,7 @@ namespace sail {
             }
 
             void moveToNextEvent() {
-                if (currentTimelineIndex < eventList.size() - 1)
+                if (currentTimelineIndex + 1 < size())
                     setTimelineIndex(currentTimelineIndex+1);
             }
             void moveToPrevEvent() {
@@ -93,55 +375,41 @@ namespace sail {
                     setTimelineIndex(currentTimelineIndex-1);
             }
 
-            unsigned long long getIndexInSortedList(vector<unsigned long long> &list, unsigned long long searchValue) {
-                if (list.size() <= 1) return 0;
-                unsigned long long minIndex = 0, middleIndex = 0;
-                unsigned long long maxIndex = list.size() - 1;
-                while (minIndex <= maxIndex) {
-                    middleIndex = (minIndex + maxIndex) / 2;
-                    if (list[middleIndex] == searchValue)
-                        return middleIndex;
-                    else if (list[middleIndex] > searchValue) {
-                        if (middleIndex == 0)
-                            break;
-                        maxIndex = middleIndex - 1;
-                    } else
-                        minIndex = middleIndex + 1;
-                }
-                return minIndex;
+            // Queries of the events at a location (hovering, navigation). They do not change
+            // the timeline and do not allocate, so they can run on any number of threads
+            // while the timeline does not change. nullopt if there is no such event.
+            // The last event at the location before index, and the first event after it
+            optional<unsigned long long> findPrevEvent(unsigned long long index, EVENT_TYPE type,
+                    NodeID node1 = 0, NodeID node2 = 0) const {
+                LocationID location = locationEvents.find(EventLocation{ type, uint32_t(node1), uint32_t(node2) });
+                if (location == LocationIndex::NOT_FOUND)
+                    return nullopt;
+                return locationEvents.getPrevEvent(location, index);
             }
-
-            unsigned long long getPrevEventIndex(unsigned long long currentIndex, EVENT_TYPE type,
-                    NodeID node1 = 0, NodeID node2 = 0) {
-                auto eventTuple = make_tuple(type, node1, node2);
-                auto size = eventData[eventTuple].size();
-                if (size == 0) return currentTimelineIndex;
-
-                auto eventDataIndex = getIndexInSortedList(eventData[eventTuple], currentTimelineIndex);
-                if (eventDataIndex == 0)
-                    return eventData[eventTuple][0];
-                return eventData[eventTuple][eventDataIndex - 1];
+            optional<unsigned long long> findNextEvent(unsigned long long index, EVENT_TYPE type,
+                    NodeID node1 = 0, NodeID node2 = 0) const {
+                LocationID location = locationEvents.find(EventLocation{ type, uint32_t(node1), uint32_t(node2) });
+                if (location == LocationIndex::NOT_FOUND)
+                    return nullopt;
+                return locationEvents.getNextEvent(location, index);
             }
-            unsigned long long getNextEventIndex(unsigned long long currentIndex, EVENT_TYPE type,
-                    NodeID node1 = 0, NodeID node2 = 0) {
-                auto eventTuple = make_tuple(type, node1, node2);
-                auto size = eventData[eventTuple].size();
-                if (size == 0) return currentTimelineIndex;
-
-                auto eventDataIndex = getIndexInSortedList(eventData[eventTuple], currentTimelineIndex);
-                if (eventDataIndex == size - 1)
-                    return eventData[eventTuple][size - 1];
-                return eventData[eventTuple][eventDataIndex + 1];
+            // The last event at the location
+            optional<unsigned long long> findLastEvent(EVENT_TYPE type, NodeID node1 = 0, NodeID node2 = 0) const {
+                LocationID location = locationEvents.find(EventLocation{ type, uint32_t(node1), uint32_t(node2) });
+                if (location == LocationIndex::NOT_FOUND)
+                    return nullopt;
+                return locationEvents.getLastEvent(location);
             }
+
+            // Previous / next event at the location of the current event,
+            // or the current event if there is none
             unsigned long long getCurrentPrevEventIndex() {
-                EVENT_TYPE type; NodeID node1, node2;
-                tie(type, ignore, ignore, node1, node2) = eventList[currentTimelineIndex];
-                return getPrevEventIndex(currentTimelineIndex, type, node1, node2);
+                return findPrevEvent(currentTimelineIndex, getEventType(currentTimelineIndex),
+                        getEventNode1(currentTimelineIndex), getEventNode2(currentTimelineIndex)).value_or(currentTimelineIndex);
             }
             unsigned long long getCurrentNextEventIndex() {
-                EVENT_TYPE type; NodeID node1, node2;
-                tie(type, ignore, ignore, node1, node2) = eventList[currentTimelineIndex];
-                return getNextEventIndex(currentTimelineIndex, type, node1, node2);
+                return findNextEvent(currentTimelineIndex, getEventType(currentTimelineIndex),
+                        getEventNode1(currentTimelineIndex), getEventNode2(currentTimelineIndex)).value_or(currentTimelineIndex);
             }
             void moveToCurrentNextEvent() {
                 setTimelineIndex(getCurrentNextEventIndex());
@@ -149,16 +417,39 @@ namespace sail {
             void moveToCurrentPrevEvent() {
                 setTimelineIndex(getCurrentPrevEventIndex());
             }
+            void moveToCurrentNextTagEvent() {
+                setTimelineIndex(getNextTagEventIndex(currentTimelineIndex, getEventTagID(currentTimelineIndex)));
+            }
+            void moveToCurrentPrevTagEvent() {
+                setTimelineIndex(getPrevTagEventIndex(currentTimelineIndex, getEventTagID(currentTimelineIndex)));
+            }
+
+            // Returns the next / previous event whose group differs from
+            // the group of the event before it, or currentIndex if there is none
+            unsigned long long getNextGroupSwitchIndex(unsigned long long currentIndex) {
+                auto next = upper_bound(groupSwitches.begin(), groupSwitches.end(), currentIndex);
+                return next == groupSwitches.end() ? currentIndex : *next;
+            }
+            unsigned long long getPrevGroupSwitchIndex(unsigned long long currentIndex) {
+                auto next = lower_bound(groupSwitches.begin(), groupSwitches.end(), currentIndex);
+                return next == groupSwitches.begin() ? currentIndex : *(next - 1);
+            }
+            void moveToNextGroupSwitch() {
+                setTimelineIndex(getNextGroupSwitchIndex(currentTimelineIndex));
+            }
+            void moveToPrevGroupSwitch() {
+                setTimelineIndex(getPrevGroupSwitchIndex(currentTimelineIndex));
+            }
 
-            string getCurrentGroup(Graph &graph) {
-                unsigned long long lastGraphEventIndex = currentTimelineIndex;
-                if (eventList.size() == 0) return "";
-                while (lastGraphEventIndex > 0 && get<0>(eventList[lastGraphEventIndex]) == GLOBAL_INFO)
-                    lastGraphEventIndex--;
-                if (get<0>(eventList[lastGraphEventIndex]) == GLOBAL_INFO)
-                    return "";
-                NodeID lastActiveNode = get<3>(eventList[lastGraphEventIndex]);
-                return graph.getNodeGroupName(lastActiveNode);
+            GroupID getCurrentGroup(Graph &graph) {
+                // Before the first event, show the group of the first node
+                if (eventGroups.empty())
+                    return graph.size() == 0 ? NO_GROUP : graph.getNodeGroupID(0);
+                uint32_t group = eventGroups[min<unsigned long long>(currentTimelineIndex, eventGroups.size() - 1)];
+                // Only global events so far, show the nodes without a group
+                if (group == NO_GROUP_ID)
+                    return graph.getGroupID("");
+                return group;
             }
     };
 
@@ -166,17 +457,107 @@ namespace sail {
         private:
             // Filename of the trace
             string filename;
+            // Contents of the trace file. Graph and Timeline keep views into it,
+            // so it has to outlive them (and hence is declared before them)
+            MappedFile traceFile;
+            // Cache file the trace was loaded from, if any (tracecache.cpp)
+            MappedFile cacheFile;
+            // Sidecar index the trace was loaded from, if any (traceindex.cpp)
+            MappedFile indexFile;
+            // Streamed text that was not parsed yet. It holds the last instruction,
+            // which may not be complete, and grows until a new instruction starts
+            vector<char> pendingText;
             // Graph representation
             Graph graph;
             // Timeline
             Timeline timeline;
-            
-            void processInstruction(string currentInstruction);
+
+            // Loading options
+            unsigned jobs;
+            bool useCache;
+            // Bytes of memory the trace may use (0 for no limit), and the bytes
+            // it used when the budget was last enforced
+            size_t memoryBudget = 0;
+            atomic<size_t> memoryUsed{0};
+            // The trace can be loaded on a background thread while it is rendered.
+            // The loader takes the mutex whenever it changes the graph or the
+            // timeline, and render() holds it for the whole frame
+            thread loader;
+            mutex traceMutex;
+            atomic<bool> loading{false};
+            atomic<bool> cancelLoading{false};
+            // Set while the instructions appended to the trace or received
+            // from the socket are parsed (tracefollow.cpp)
+            atomic<bool> following{false};
+            // Compression of the trace file, and how much of it was decompressed so far
+            COMPRESSION_TYPE compression = COMPRESSION_NONE;
+            atomic<size_t> decompressedBytes{0};
+            // Socket the trace is received from, if any
+            bool listening = false;
+            TraceSocket traceSocket;
+            ChunkQueue streamQueue;
+            // Bytes of the trace file that are part of the graph and timeline
+            atomic<size_t> loadedBytes{0};
+            chrono::steady_clock::time_point loadStartTime;
+
+            void loadContents();
+            void appendContents(string_view text);
+            void finishContents();
+            void followContents(size_t parsedSize);
+            void receiveContents();
+            void parseCompressed(string_view contents);
+            void processInstruction(const Instruction &instruction);
+            void parseText(string_view contents);
+            void parseSerial(string_view contents);
+            void parseParallel(string_view contents, unsigned jobs);
+            void loadBinary(string_view contents);
+            void loadBinary(const BinaryTraceReader &reader);
+            bool loadCache(const TraceCacheKey &key, uint64_t contentHash);
+            void writeCache(const TraceCacheKey &key, uint64_t contentHash);
+            bool loadIndex(const TraceCacheKey &key);
+            void printLoadStatistics(double seconds);
+            void enforceMemoryBudget();
 
         public:
-            // Constructor which reads file 
-            // and parses the trace
-            Trace(string _filename);
+            // Constructor which opens the file. The trace is parsed by load()
+            // or loadInBackground() using the given number of threads
+            // (0 : one per core). If useCache is set, text traces are loaded
+            // from their sidecar index when it is up to date, and large text
+            // traces are loaded from and saved to the trace cache
+            Trace(string _filename, unsigned jobs = 0, bool useCache = true);
+            // Constructor for a trace that is received from an analysis
+            // through listenInBackground()
+            Trace();
+            Trace(const Trace &) = delete;
+            Trace &operator=(const Trace &) = delete;
+            // Stops a background load that is still running
+            ~Trace();
+
+            // Parses the trace and returns once it is loaded
+            void load();
+            // Parses the trace on a background thread. The parts of the trace
+            // that are loaded are rendered while the rest is parsed.
+            // With follow, the thread then keeps parsing the instructions that
+            // are appended to the trace, until the Trace is destroyed
+            void loadInBackground(bool follow = false);
+            // Waits for an analysis to connect to the Unix domain socket at
+            // socketPath, and parses the trace it sends on a background thread
+            void listenInBackground(const string &socketPath);
+            bool isLoading()    { return loading; }
+            bool isFollowing()  { return following; }
+            // Limits the memory used by the trace to about the given number of bytes,
+            // to be set before the trace is loaded. The compressed info bodies that
+            // were not read recently are evicted to a spill file, and the pages of
+            // the mapped trace text (node contents) are left to be read again from it
+            void setMemoryBudget(size_t bytes)  { memoryBudget = bytes; }
+
+            // Writes the parsed trace in the binary trace format.
+            // Returns false if the file could not be written
+            bool writeBinary(const string &binaryFilename);
+            // Writes the sidecar index of the parsed text trace.
+            // Returns false if the trace can not be indexed or the file
+            // could not be written
+            bool writeIndex();
 
             // Main Render function
             void render();
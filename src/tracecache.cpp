@@ -0,0 +1,145 @@
+/*
+ * Cache of parsed text traces
+ */
+#include "tracecache.h"
+#include "hash.h"
+#include "parallel.h"
+#include "trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#ifndef _WIN32
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+namespace sail {
+
+    // Size of the blocks of the trace hashed in parallel
+    const size_t TRACE_HASH_BLOCK_SIZE = 16 << 20;
+
+    bool getTraceCacheKey(const string &filename, TraceCacheKey &key) {
+#ifdef _WIN32
+        return false;
+#else
+        char absolutePath[PATH_MAX];
+        if (realpath(filename.c_str(), absolutePath) == nullptr)
+            return false;
+        struct stat st;
+        if (stat(absolutePath, &st) != 0 || !S_ISREG(st.st_mode))
+            return false;
+        key.path = absolutePath;
+        key.size = st.st_size;
+#ifdef __APPLE__
+        key.modificationTime = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+        key.modificationTime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+        return true;
+#endif
+    }
+
+#ifndef _WIN32
+    // Creates the absolute directory and every missing parent, like mkdir -p
+    static void makeDirectories(const string &directory) {
+        for (size_t slash = directory.find('/', 1); slash != string::npos; slash = directory.find('/', slash + 1))
+            mkdir(directory.substr(0, slash).c_str(), 0755);
+        mkdir(directory.c_str(), 0755);
+    }
+
+    // $XDG_CACHE_HOME/sail_viewer or ~/.cache/sail_viewer, created if needed
+    static string getCacheDirectory() {
+        string directory;
+        const char *cacheHome = getenv("XDG_CACHE_HOME");
+        const char *home = getenv("HOME");
+        if (cacheHome != nullptr && cacheHome[0] == '/') {
+            directory = cacheHome;
+        } else if (home != nullptr && home[0] == '/') {
+            directory = string(home) + "/.cache";
+        } else {
+            return string();
+        }
+        directory += "/sail_viewer";
+        makeDirectories(directory);
+        struct stat st;
+        if (stat(directory.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+            return string();
+        return directory;
+    }
+#endif
+
+    string getTraceCachePath(const TraceCacheKey &key) {
+#ifdef _WIN32
+        return string();
+#else
+        string directory = getCacheDirectory();
+        if (directory.empty())
+            return string();
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.sailb", (unsigned long long)hashBytes(key.path));
+        return directory + "/" + name;
+#endif
+    }
+
+    uint64_t hashTraceContents(string_view contents, unsigned jobs) {
+        size_t blockCount = (contents.size() + TRACE_HASH_BLOCK_SIZE - 1) / TRACE_HASH_BLOCK_SIZE;
+        vector<uint64_t> blockHashes(blockCount);
+        parallelFor(blockCount, jobs, [&](size_t block) {
+            blockHashes[block] = hashBytes(contents.substr(block * TRACE_HASH_BLOCK_SIZE, TRACE_HASH_BLOCK_SIZE), block);
+        });
+        return hashBytes(reinterpret_cast<const char *>(blockHashes.data()),
+                blockHashes.size() * sizeof(uint64_t), contents.size());
+    }
+
+    bool matchesTraceCache(const BinaryTraceReader &reader, const TraceCacheKey &key, uint64_t contentHash) {
+        const BinarySource *source = reader.getSource();
+        return source != nullptr && source->size == key.size &&
+            source->modificationTime == key.modificationTime &&
+            source->contentHash == contentHash && reader.getString(source->path) == key.path;
+    }
+
+    bool writeTraceCache(BinaryTraceWriter &writer, const TraceCacheKey &key, uint64_t contentHash) {
+#ifdef _WIN32
+        return false;
+#else
+        string cachePath = getTraceCachePath(key);
+        if (cachePath.empty())
+            return false;
+        writer.setSource(key.path, key.size, key.modificationTime, contentHash);
+        string temporaryPath = cachePath + "." + to_string(getpid()) + ".tmp";
+        if (!writer.write(temporaryPath) || rename(temporaryPath.c_str(), cachePath.c_str()) != 0) {
+            remove(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    bool Trace::loadCache(const TraceCacheKey &key, uint64_t contentHash) {
+        if (!cacheFile.open(getTraceCachePath(key)))
+            return false;
+        BinaryTraceReader reader;
+        string error;
+        if (!reader.open(cacheFile.view(), error) || !matchesTraceCache(reader, key, contentHash))
+            return false;
+        lock_guard<mutex> lock(traceMutex);
+        loadBinary(reader);
+        return true;
+    }
+
+    void Trace::writeCache(const TraceCacheKey &key, uint64_t contentHash) {
+        BinaryTraceWriter writer;
+        {
+            lock_guard<mutex> lock(traceMutex);
+            graph.writeBinary(writer);
+            timeline.writeBinary(writer);
+        }
+        if (!writeTraceCache(writer, key, contentHash))
+            cout << "Unable to write the trace cache for " << key.path << "\n";
+    }
+
+}
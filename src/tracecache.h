@@ -0,0 +1,58 @@
+/*
+ * Cache of parsed text traces
+ *
+ * After a text trace is parsed, the Graph and Timeline are written out in
+ * the binary trace format to the user cache directory, along with the
+ * path, size, modification time and content hash of the text trace. The
+ * next time the same trace is opened, the cache file is mapped and loaded
+ * like any binary trace instead of parsing the text again. This skips the
+ * tokenizing and parsing, but the Graph and Timeline are still rebuilt from
+ * the columns in time linear in the trace. A cache file that does not match
+ * the trace anymore is ignored and overwritten after parsing.
+ */
+#ifndef SAIL_TRACECACHE_H
+#define SAIL_TRACECACHE_H
+
+#include "binarytrace.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace sail {
+
+    // Text traces smaller than this are parsed faster than the cache is checked
+    const size_t TRACE_CACHE_THRESHOLD = 1 << 20;
+
+    // Identifies the version of a text trace on disk
+    struct TraceCacheKey {
+        // Absolute path of the trace
+        string path;
+        uint64_t size = 0;
+        // Nanoseconds since the epoch
+        int64_t modificationTime = 0;
+    };
+
+    // Fills the key of the given trace file.
+    // Returns false if the file can not be cached
+    bool getTraceCacheKey(const string &filename, TraceCacheKey &key);
+
+    // Returns the cache file of the trace, or an empty string
+    // if there is no cache directory
+    string getTraceCachePath(const TraceCacheKey &key);
+
+    // Hash of the whole trace text, computed on up to jobs threads
+    uint64_t hashTraceContents(string_view contents, unsigned jobs);
+
+    // Returns true if the binary trace is a cache of the given version of the trace
+    bool matchesTraceCache(const BinaryTraceReader &reader, const TraceCacheKey &key, uint64_t contentHash);
+
+    // Writes the binary trace to the cache file of the trace.
+    // The file is written next to the cache file and renamed over it,
+    // so that other instances never map a partially written cache
+    bool writeTraceCache(BinaryTraceWriter &writer, const TraceCacheKey &key, uint64_t contentHash);
+
+}
+
+#endif
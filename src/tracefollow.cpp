@@ -0,0 +1,149 @@
+/*
+ * Streamed traces : parsing of the instructions appended to a trace that is
+ * still being written (follow mode), received from a socket, or decompressed
+ */
+#include "trace.h"
+#include "filewatcher.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace sail {
+
+    // Largest amount of appended text that is read and parsed at once
+    const size_t FOLLOW_READ_SIZE = 16 << 20;
+    // Time spent collecting appended text before it is parsed, so that a fast
+    // writer causes a few large updates of the trace instead of many small ones
+    const chrono::milliseconds FOLLOW_BATCH_INTERVAL(10);
+    // Interval at which the file size is checked when no change was notified
+    const int FOLLOW_POLL_INTERVAL = 100;
+
+    // Streamed text is parsed up to its last instruction, which may not be complete
+    // yet. The last instruction is kept pending and parsed along with the next text,
+    // or by finishContents() once the stream ended. The parsed text is released,
+    // so the graph and timeline copy the strings they keep from it
+    void Trace::appendContents(string_view text) {
+        graph.setCopyStrings(true);
+        timeline.setCopyStrings(true);
+        // Only the new text can start an instruction, along with the two bytes before
+        // it in case it splits a "\n>>"
+        size_t scanStart = pendingText.size() < 2 ? 0 : pendingText.size() - 2;
+        pendingText.insert(pendingText.end(), text.begin(), text.end());
+        string_view contents(pendingText.data(), pendingText.size());
+        size_t lastInstruction = findLastInstruction(contents.substr(scanStart));
+        if (lastInstruction == 0)
+            return;
+        lastInstruction += scanStart;
+
+        parseText(contents.substr(0, lastInstruction));
+        pendingText.erase(pendingText.begin(), pendingText.begin() + lastInstruction);
+    }
+
+    void Trace::finishContents() {
+        if (pendingText.empty())
+            return;
+        parseSerial(string_view(pendingText.data(), pendingText.size()));
+        vector<char>().swap(pendingText);
+    }
+
+    // Reads the text appended to the trace after the first parsedSize bytes
+    void Trace::followContents(size_t parsedSize) {
+        FileWatcher watcher;
+        watcher.open(filename);
+        ifstream traceStream(filename, ios::binary);
+        if (!traceStream) {
+            cout << "Unable to follow tracefile " << filename << "\n";
+            following = false;
+            return;
+        }
+
+        // The pending instruction is copied out of the mapping, which can not grow
+        size_t readSize = traceFile.size();
+        string_view lastInstruction = traceFile.view().substr(parsedSize);
+        pendingText.assign(lastInstruction.begin(), lastInstruction.end());
+        vector<char> text;
+        while (!cancelLoading) {
+            error_code error;
+            uintmax_t fileSize = filesystem::file_size(filename, error);
+            if (error || fileSize < readSize) {
+                cout << "Tracefile " << filename << " was truncated or removed, stopped following it\n";
+                break;
+            }
+            if (fileSize == readSize) {
+                watcher.wait(FOLLOW_POLL_INTERVAL);
+                this_thread::sleep_for(FOLLOW_BATCH_INTERVAL);
+                continue;
+            }
+
+            text.resize(min<uintmax_t>(fileSize - readSize, FOLLOW_READ_SIZE));
+            traceStream.clear();
+            traceStream.seekg(readSize);
+            traceStream.read(text.data(), text.size());
+            size_t appendedSize = traceStream.gcount();
+            if (appendedSize == 0) {
+                watcher.wait(FOLLOW_POLL_INTERVAL);
+                continue;
+            }
+            readSize += appendedSize;
+            appendContents(string_view(text.data(), appendedSize));
+        }
+        following = false;
+    }
+
+    void Trace::listenInBackground(const string &socketPath) {
+        string error;
+        if (!traceSocket.listen(socketPath, error)) {
+            cout << "Unable to listen on " << socketPath << " : " << error << "\n";
+            exit(0);
+        }
+        this->filename = socketPath;
+        cout << "Waiting for the trace on " << socketPath << "\n";
+        listening = true;
+        following = true;
+        loadStartTime = chrono::steady_clock::now();
+        traceSocket.receiveInBackground(streamQueue);
+        loader = thread(&Trace::receiveContents, this);
+    }
+
+    // Parses the text received on the socket. Everything that arrived since the
+    // last batch is parsed at once, and batches are at least FOLLOW_BATCH_INTERVAL
+    // apart, so that the trace is updated a few times per frame at most
+    void Trace::receiveContents() {
+        vector<char> text;
+        while (!cancelLoading && streamQueue.pop(text)) {
+            appendContents(string_view(text.data(), text.size()));
+            this_thread::sleep_for(FOLLOW_BATCH_INTERVAL);
+        }
+        // The connection was closed, so the last instruction is complete
+        if (!cancelLoading) {
+            finishContents();
+            chrono::duration<double> loadTime = chrono::steady_clock::now() - loadStartTime;
+            lock_guard<mutex> lock(traceMutex);
+            cout << "Received " << loadedBytes / (1024.0 * 1024.0) << " MB in " << loadTime.count() << " s : " <<
+                graph.size() << " nodes, " << timeline.size() << " events\n";
+        }
+        following = false;
+    }
+
+    // The trace is decompressed on a separate thread and parsed as the text arrives
+    void Trace::parseCompressed(string_view contents) {
+        string error;
+        bool decompressed = true;
+        thread decompressor([&]() {
+            decompressed = decompress(contents, compression, streamQueue, decompressedBytes, error);
+        });
+        vector<char> text;
+        while (!cancelLoading && streamQueue.pop(text))
+            appendContents(string_view(text.data(), text.size()));
+        decompressor.join();
+        if (!decompressed) {
+            cout << "Unable to decompress tracefile " << filename << " : " << error << "\n";
+            exit(0);
+        }
+        if (!cancelLoading)
+            finishContents();
+    }
+
+}
@@ -0,0 +1,104 @@
+/*
+ * Sidecar index of text traces
+ */
+#include "traceindex.h"
+#include "hash.h"
+#include "parser.h"
+#include "trace.h"
+#include <cstdio>
+#include <iostream>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace sail {
+
+    // Size of the blocks at the start and the end of the trace that are hashed
+    const size_t TRACE_SAMPLE_SIZE = 1 << 20;
+
+    string getTraceIndexPath(const string &filename) {
+        return filename + ".sailx";
+    }
+
+    uint64_t hashTraceSample(string_view contents) {
+        uint64_t hash = hashBytes(contents.substr(0, TRACE_SAMPLE_SIZE), contents.size());
+        if (contents.size() > TRACE_SAMPLE_SIZE)
+            hash = hashBytes(contents.substr(contents.size() - TRACE_SAMPLE_SIZE), hash);
+        return hash;
+    }
+
+    bool matchesTraceIndex(const BinaryTraceReader &reader, const TraceCacheKey &key, uint64_t sampleHash) {
+        // The path is not compared, the index can be moved along with the trace
+        const BinarySource *source = reader.getSource();
+        return source != nullptr && source->size == key.size &&
+            source->modificationTime == key.modificationTime && source->contentHash == sampleHash;
+    }
+
+    bool writeTraceIndex(BinaryTraceWriter &writer, const string &indexPath,
+            const TraceCacheKey &key, uint64_t sampleHash) {
+#ifdef _WIN32
+        return false;
+#else
+        writer.setSource(key.path, key.size, key.modificationTime, sampleHash);
+        string temporaryPath = indexPath + "." + to_string(getpid()) + ".tmp";
+        if (!writer.write(temporaryPath) || rename(temporaryPath.c_str(), indexPath.c_str()) != 0) {
+            remove(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    bool Trace::loadIndex(const TraceCacheKey &key) {
+        string indexPath = getTraceIndexPath(filename);
+        if (!indexFile.open(indexPath))
+            return false;
+        BinaryTraceReader reader;
+        string error;
+        if (!reader.open(indexFile.view(), error, traceFile.view())) {
+            cout << "Ignoring the index " << indexPath << " : " << error << "\n";
+            return false;
+        }
+        if (!matchesTraceIndex(reader, key, hashTraceSample(traceFile.view()))) {
+            cout << "Ignoring the index " << indexPath << ", the tracefile changed since it was written\n";
+            return false;
+        }
+        // The info bodies are read as their events are displayed
+        traceFile.adviseRandomAccess();
+        lock_guard<mutex> lock(traceMutex);
+        loadBinary(reader);
+        return true;
+    }
+
+    bool Trace::writeIndex() {
+        TraceCacheKey key;
+        string_view contents = traceFile.view();
+        if (isBinaryTrace(contents) || compression != COMPRESSION_NONE || !getTraceCacheKey(filename, key))
+            return false;
+        BinaryTraceWriter writer;
+        writer.setText(contents);
+        {
+            lock_guard<mutex> lock(traceMutex);
+            graph.writeBinary(writer);
+            // The info strings keep no position in the text, which is scanned again :
+            // every info string gets the body of the first event that stored it
+            vector<string_view> infoTexts(timeline.infoStrSize());
+            unsigned long long eventIndex = 0;
+            for (size_t offset = 0; offset < contents.size() && eventIndex < timeline.size(); ) {
+                Instruction instruction = parseInstruction(nextInstruction(contents, offset));
+                if (instruction.type == INSTR_NODE || instruction.type == INSTR_EDGE ||
+                        instruction.type == INSTR_UNKNOWN)
+                    continue;
+                unsigned long long info = timeline.getEventInfoIndex(eventIndex++);
+                if ((instruction.type == INSTR_NODEINFO || instruction.type == INSTR_EDGEINFO ||
+                            instruction.type == INSTR_GLOBALINFO) && info != NO_INFO && infoTexts[info].data() == nullptr)
+                    infoTexts[info] = instruction.body;
+            }
+            timeline.writeBinary(writer, infoTexts);
+        }
+        return writeTraceIndex(writer, getTraceIndexPath(filename), key, hashTraceSample(contents));
+    }
+
+}
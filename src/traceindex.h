@@ -0,0 +1,47 @@
+/*
+ * Sidecar index of text traces (<tracefile>.sailx)
+ *
+ * The index is a binary trace whose strings are not copied : node names,
+ * contents and tags, and the body of every distinct info string, are stored
+ * as their offset and length in the text trace. A trace that has an up to
+ * date index is opened by mapping the index instead of parsing the text. The
+ * node contents and info bodies stay in the mapped trace, and are only read
+ * when they are displayed, so that traces larger than the memory can be browsed.
+ *
+ * The index matches the trace as long as its size, modification time and
+ * the hash of its first and last blocks did not change. Unlike the trace
+ * cache, the whole trace is never read to check it : a change in the middle
+ * of the trace that keeps its size and modification time (an edit followed
+ * by touch -r, or a copy that preserves the times) is not detected, and the
+ * index then shows the wrong text. Delete the index after such a change.
+ */
+#ifndef SAIL_TRACEINDEX_H
+#define SAIL_TRACEINDEX_H
+
+#include "binarytrace.h"
+#include "tracecache.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace sail {
+
+    // Returns the path of the sidecar index of the trace
+    string getTraceIndexPath(const string &filename);
+
+    // Hash of the first and last blocks of the trace
+    uint64_t hashTraceSample(string_view contents);
+
+    // Returns true if the index was created from the given version of the trace
+    bool matchesTraceIndex(const BinaryTraceReader &reader, const TraceCacheKey &key, uint64_t sampleHash);
+
+    // Writes the index to indexPath. As for the cache, the file is written
+    // next to indexPath and renamed over it
+    bool writeTraceIndex(BinaryTraceWriter &writer, const string &indexPath,
+            const TraceCacheKey &key, uint64_t sampleHash);
+
+}
+
+#endif
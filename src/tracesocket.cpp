@@ -0,0 +1,109 @@
+/*
+ * Unix domain socket on which an analysis streams its trace to the viewer
+ */
+#include "tracesocket.h"
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+using namespace std;
+
+namespace sail {
+
+    // Size of the reads from the socket, and hence of the queued chunks
+    const size_t SOCKET_READ_SIZE = 1 << 20;
+    // Interval at which a blocked receiver checks whether it was stopped
+    const int SOCKET_POLL_INTERVAL = 100;
+
+    TraceSocket::~TraceSocket() {
+        stop();
+    }
+
+    bool TraceSocket::listen(const string &socketPath, string &error) {
+#ifdef _WIN32
+        error = "Unix domain sockets are not supported on this platform";
+        return false;
+#else
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            error = "Socket path is too long";
+            return false;
+        }
+        memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+
+        // Remove the socket left behind by an earlier viewer, but never a regular file
+        struct stat st;
+        if (lstat(socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+            unlink(socketPath.c_str());
+
+        listenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFD < 0 || bind(listenFD, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+                ::listen(listenFD, 1) != 0) {
+            error = strerror(errno);
+            if (listenFD >= 0)
+                close(listenFD);
+            listenFD = -1;
+            return false;
+        }
+        path = socketPath;
+        return true;
+#endif
+    }
+
+    void TraceSocket::receiveInBackground(ChunkQueue &queue) {
+        receiver = thread(&TraceSocket::receive, this, ref(queue));
+    }
+
+    void TraceSocket::receive(ChunkQueue &queue) {
+#ifndef _WIN32
+        // Wait for the analysis to connect
+        int connectionFD = -1;
+        while (!stopping && connectionFD < 0) {
+            struct pollfd pollFD = { listenFD, POLLIN, 0 };
+            if (poll(&pollFD, 1, SOCKET_POLL_INTERVAL) > 0)
+                connectionFD = accept(listenFD, nullptr, nullptr);
+        }
+
+        vector<char> buffer(SOCKET_READ_SIZE);
+        while (!stopping && connectionFD >= 0) {
+            struct pollfd pollFD = { connectionFD, POLLIN, 0 };
+            if (poll(&pollFD, 1, SOCKET_POLL_INTERVAL) <= 0)
+                continue;
+            ssize_t received = read(connectionFD, buffer.data(), buffer.size());
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                break;
+            // Blocks while the parser is behind
+            if (!queue.push(vector<char>(buffer.begin(), buffer.begin() + received)))
+                break;
+        }
+        if (connectionFD >= 0)
+            close(connectionFD);
+#endif
+        queue.close();
+    }
+
+    void TraceSocket::stop() {
+        stopping = true;
+        if (receiver.joinable())
+            receiver.join();
+#ifndef _WIN32
+        if (listenFD >= 0) {
+            close(listenFD);
+            unlink(path.c_str());
+            listenFD = -1;
+        }
+#endif
+    }
+
+}
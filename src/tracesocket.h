@@ -0,0 +1,48 @@
+/*
+ * Unix domain socket on which an analysis streams its trace to the viewer
+ */
+#ifndef SAIL_TRACESOCKET_H
+#define SAIL_TRACESOCKET_H
+
+#include "chunkqueue.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace sail {
+
+    // Accepts a single connection and passes the received text to the parser
+    // through a ChunkQueue. When the queue is full the socket is not read,
+    // which blocks the writes of the analysis
+    class TraceSocket {
+        private:
+            string path;
+            int listenFD = -1;
+            thread receiver;
+            atomic<bool> stopping{false};
+
+            void receive(ChunkQueue &queue);
+
+        public:
+            TraceSocket() {}
+            ~TraceSocket();
+            TraceSocket(const TraceSocket &) = delete;
+            TraceSocket &operator=(const TraceSocket &) = delete;
+
+            // Creates the socket at the given path, replacing a stale socket.
+            // Returns false along with a message if it could not be created
+            bool listen(const string &socketPath, string &error);
+
+            // Receives the trace on a background thread. The queue is closed
+            // when the analysis closes the connection
+            void receiveInBackground(ChunkQueue &queue);
+
+            // Stops receiving and removes the socket
+            void stop();
+    };
+
+}
+
+#endif